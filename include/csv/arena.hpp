@@ -0,0 +1,161 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace csv {
+
+  // A fixed-size block of memory handed out front to back. Nothing is
+  // freed individually: the whole chunk goes away with its last owner
+  class ArenaChunk {
+  public:
+    explicit ArenaChunk(size_t capacity) :
+      data_(new char[capacity]),
+      capacity_(capacity),
+      used_(0) {}
+
+    ArenaChunk(const ArenaChunk&) = delete;
+    ArenaChunk& operator=(const ArenaChunk&) = delete;
+
+    // Returns nullptr if the chunk doesn't have size bytes left
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+      size_t start = (used_ + alignment - 1) & ~(alignment - 1);
+      if (start > capacity_ || capacity_ - start < size)
+        return nullptr;
+      used_ = start + size;
+      return data_.get() + start;
+    }
+
+    size_t capacity() const {
+      return capacity_;
+    }
+
+    size_t used() const {
+      return used_;
+    }
+
+    // Start over from the front. Only for chunks nobody points into anymore
+    void reset() {
+      used_ = 0;
+    }
+
+  private:
+    std::unique_ptr<char[]> data_;
+    size_t capacity_;
+    size_t used_;
+  };
+
+  // Hands out memory from reference-counted chunks. Whatever is allocated
+  // from a chunk stays valid as long as a copy of the chunk's pointer, see 
+  // chunk(), is alive, so many small objects share a single allocation.
+  // Chunks are recycled once nothing else points to them, so an arena 
+  // whose allocations are released at the rate they're made stops 
+  // allocating after a while
+  class Arena {
+  public:
+    explicit Arena(size_t chunk_size = 1 << 20, size_t max_pooled_chunks = 64) :
+      chunk_size_(chunk_size),
+      max_pooled_chunks_(max_pooled_chunks),
+      chunks_(0),
+      next_pooled_chunk_(0) {}
+
+    // Allocates from the current chunk, or from a new one when it is full.
+    // Requests larger than the chunk size get a chunk of their own
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+      if (chunk_) {
+        if (void* result = chunk_->allocate(size, alignment))
+          return result;
+      }
+      if (size + alignment > chunk_size_) {
+        chunk_ = std::make_shared<ArenaChunk>(size + alignment);
+        chunks_ += 1;
+      }
+      else if (!reuse_chunk()) {
+        chunk_ = std::make_shared<ArenaChunk>(chunk_size_);
+        chunks_ += 1;
+        if (pool_.size() < max_pooled_chunks_)
+          pool_.push_back(chunk_);
+      }
+      return chunk_->allocate(size, alignment);
+    }
+
+    template <typename T>
+    T* allocate_array(size_t count) {
+      return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // The chunk the last allocation came from
+    const std::shared_ptr<ArenaChunk>& chunk() const {
+      return chunk_;
+    }
+
+    size_t chunk_size() const {
+      return chunk_size_;
+    }
+
+    // Number of chunks allocated so far
+    size_t chunks() const {
+      return chunks_;
+    }
+
+  private:
+    // Make a pooled chunk that only the arena still points to the current
+    // chunk. The chunks are checked round-robin, oldest first
+    bool reuse_chunk() {
+      chunk_.reset();
+      for (size_t i = 0; i < pool_.size(); ++i) {
+        auto& chunk = pool_[next_pooled_chunk_];
+        next_pooled_chunk_ = (next_pooled_chunk_ + 1) % pool_.size();
+        if (chunk.use_count() == 1) {
+          // Whoever dropped the last reference is done reading the chunk
+          std::atomic_thread_fence(std::memory_order_acquire);
+          chunk->reset();
+          chunk_ = chunk;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    size_t chunk_size_;
+    size_t max_pooled_chunks_;
+    size_t chunks_;
+    std::shared_ptr<ArenaChunk> chunk_;
+    std::vector<std::shared_ptr<ArenaChunk>> pool_;
+    size_t next_pooled_chunk_;
+  };
+
+}
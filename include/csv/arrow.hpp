@@ -0,0 +1,262 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/batch.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The structs of the Arrow C Data Interface, as laid out in the spec
+// (https://arrow.apache.org/docs/format/CDataInterface.html). Nothing
+// from the Arrow libraries is needed to produce them
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif
+
+namespace csv {
+
+  namespace detail {
+
+    // Owned by an exported ArrowSchema, freed by its release callback
+    struct ArrowSchemaData {
+      std::string format;
+      std::string name;
+      std::vector<ArrowSchema*> children;
+      ArrowSchema* dictionary = nullptr;
+    };
+
+    // Owned by an exported ArrowArray. owner keeps the record batch, and
+    // so the buffers, alive until the consumer releases the array
+    struct ArrowArrayData {
+      std::shared_ptr<const RecordBatch> owner;
+      std::vector<const void*> buffers;
+      std::vector<int64_t> decimals;
+      std::vector<ArrowArray*> children;
+      ArrowArray* dictionary = nullptr;
+    };
+
+    inline void release_schema(ArrowSchema* schema) {
+      auto* data = static_cast<ArrowSchemaData*>(schema->private_data);
+      for (ArrowSchema* child : data->children) {
+        if (child->release)
+          child->release(child);
+        delete child;
+      }
+      if (data->dictionary) {
+        if (data->dictionary->release)
+          data->dictionary->release(data->dictionary);
+        delete data->dictionary;
+      }
+      delete data;
+      schema->release = nullptr;
+    }
+
+    inline void release_array(ArrowArray* array) {
+      auto* data = static_cast<ArrowArrayData*>(array->private_data);
+      for (ArrowArray* child : data->children) {
+        if (child->release)
+          child->release(child);
+        delete child;
+      }
+      if (data->dictionary) {
+        if (data->dictionary->release)
+          data->dictionary->release(data->dictionary);
+        delete data->dictionary;
+      }
+      delete data;
+      array->release = nullptr;
+    }
+
+    inline void make_schema(ArrowSchema* schema, std::string format, std::string name, int64_t flags) {
+      auto* data = new ArrowSchemaData();
+      data->format = std::move(format);
+      data->name = std::move(name);
+      schema->format = data->format.c_str();
+      schema->name = data->name.c_str();
+      schema->metadata = nullptr;
+      schema->flags = flags;
+      schema->n_children = 0;
+      schema->children = nullptr;
+      schema->dictionary = nullptr;
+      schema->release = &release_schema;
+      schema->private_data = data;
+    }
+
+    inline ArrowArrayData* make_array(ArrowArray* array, const std::shared_ptr<const RecordBatch>& owner,
+      int64_t length, int64_t null_count, std::vector<const void*> buffers) {
+      auto* data = new ArrowArrayData();
+      data->owner = owner;
+      data->buffers = std::move(buffers);
+      array->length = length;
+      array->null_count = null_count;
+      array->offset = 0;
+      array->n_buffers = static_cast<int64_t>(data->buffers.size());
+      array->buffers = data->buffers.data();
+      array->n_children = 0;
+      array->children = nullptr;
+      array->dictionary = nullptr;
+      array->release = &release_array;
+      array->private_data = data;
+      return data;
+    }
+
+    // Arrow format string of a column, see the spec's table of formats
+    inline std::string arrow_format(ColumnType type) {
+      switch (type.type) {
+      case Type::int64: return "l";
+      case Type::float64: return "g";
+      case Type::boolean: return "b";
+      // int64 holds up to 19 digits, which always fits a decimal128
+      case Type::decimal: return "d:19," + std::to_string(type.scale);
+      case Type::timestamp: return "tsn:UTC";
+      case Type::dictionary: return "i";
+      default: return "U";
+      }
+    }
+
+    inline void export_column(const std::shared_ptr<const RecordBatch>& owner, const Column& column, ArrowArray* array) {
+      const int64_t length = static_cast<int64_t>(column.size());
+      const int64_t null_count = static_cast<int64_t>(column.null_count());
+      // Arrow lets the validity buffer be left out when nothing is null
+      const void* validity = null_count > 0 ? column.validity().data() : nullptr;
+      switch (column.type().type) {
+      case Type::int64:
+      case Type::timestamp:
+        make_array(array, owner, length, null_count, { validity, column.integers().data() });
+        break;
+      case Type::float64:
+        make_array(array, owner, length, null_count, { validity, column.floats().data() });
+        break;
+      case Type::boolean:
+        make_array(array, owner, length, null_count, { validity, column.booleans().data() });
+        break;
+      case Type::decimal: {
+        // decimal128 values are 16 bytes, little-endian two's complement.
+        // These are the only values that get copied
+        auto* data = make_array(array, owner, length, null_count, { validity, nullptr });
+        data->decimals.reserve(column.size() * 2);
+        for (int64_t value : column.integers()) {
+          data->decimals.push_back(value);
+          data->decimals.push_back(value < 0 ? -1 : 0);
+        }
+        data->buffers[1] = data->decimals.data();
+        break;
+      }
+      case Type::dictionary: {
+        auto* data = make_array(array, owner, length, null_count, { validity, column.codes().data() });
+        const Dictionary& dictionary = column.dictionary();
+        data->dictionary = new ArrowArray();
+        make_array(data->dictionary, owner, static_cast<int64_t>(dictionary.size()), 0,
+          { nullptr, dictionary.offsets().data(), dictionary.data().data() });
+        array->dictionary = data->dictionary;
+        break;
+      }
+      default:
+        make_array(array, owner, length, null_count, 
+          { validity, column.offsets().data(), column.data().data() });
+        break;
+      }
+    }
+
+  }
+
+  // Describe the columns of batch as an Arrow struct type, one child per
+  // column. The caller owns schema and must call its release callback
+  inline void export_schema(const RecordBatch& batch, ArrowSchema* schema) {
+    detail::make_schema(schema, "+s", "", 0);
+    auto* data = static_cast<detail::ArrowSchemaData*>(schema->private_data);
+    for (auto& column : batch.columns()) {
+      auto* child = new ArrowSchema();
+      detail::make_schema(child, detail::arrow_format(column.type()), column.name(), ARROW_FLAG_NULLABLE);
+      if (column.type().type == Type::dictionary) {
+        auto* child_data = static_cast<detail::ArrowSchemaData*>(child->private_data);
+        child_data->dictionary = new ArrowSchema();
+        detail::make_schema(child_data->dictionary, "U", "", 0);
+        child->dictionary = child_data->dictionary;
+      }
+      data->children.push_back(child);
+    }
+    schema->n_children = static_cast<int64_t>(data->children.size());
+    schema->children = data->children.data();
+  }
+
+  // Hand batch over as an Arrow struct array, e.g., to pyarrow, Polars or
+  // DuckDB. The column buffers are shared, not copied: the batch is kept
+  // alive until the consumer calls array's release callback. If schema is
+  // given, it is filled in as with export_schema()
+  inline void export_record_batch(RecordBatch batch, ArrowArray* array, ArrowSchema* schema = nullptr) {
+    if (schema)
+      export_schema(batch, schema);
+    auto owner = std::make_shared<const RecordBatch>(std::move(batch));
+    auto* data = detail::make_array(array, owner, static_cast<int64_t>(owner->num_rows()), 0, { nullptr });
+    for (auto& column : owner->columns()) {
+      auto* child = new ArrowArray();
+      detail::export_column(owner, column, child);
+      data->children.push_back(child);
+    }
+    array->n_children = static_cast<int64_t>(data->children.size());
+    array->children = data->children.data();
+  }
+
+}
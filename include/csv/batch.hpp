@@ -0,0 +1,419 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/types.hpp>
+#include <csv/framer.hpp>
+#include <csv/arena.hpp>
+#include <csv/robin_hood.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  // The distinct values of a Type::dictionary column, stored like a string
+  // column: value i is data()[offsets()[i], offsets()[i + 1])
+  class Dictionary {
+  public:
+    Dictionary() :
+      offsets_{ 0 } {}
+
+    size_t size() const {
+      return offsets_.size() - 1;
+    }
+
+    std::string_view value(size_t code) const {
+      return std::string_view(data_.data() + offsets_[code],
+        static_cast<size_t>(offsets_[code + 1] - offsets_[code]));
+    }
+
+    const std::vector<int64_t>& offsets() const {
+      return offsets_;
+    }
+
+    const std::string& data() const {
+      return data_;
+    }
+
+  private:
+    friend class DictionaryBuilder;
+
+    std::vector<int64_t> offsets_;
+    std::string data_;
+  };
+
+  // Interns the values of one dictionary column for the whole file, so a
+  // value gets the same code in every batch. Only used by the reading 
+  // thread; batches get immutable snapshots
+  class DictionaryBuilder {
+  public:
+    DictionaryBuilder() :
+      arena_(1 << 16) {}
+
+    // The code of value, which is added to the dictionary if it's new
+    int32_t intern(std::string_view value) {
+      auto it = codes_.find(value);
+      if (it != codes_.end())
+        return it->second;
+      // The keys point into the arena, which never moves what it holds
+      char* copy = static_cast<char*>(arena_.allocate(value.size(), 1));
+      if (value.size() > 0)
+        std::memcpy(copy, value.data(), value.size());
+      const int32_t code = static_cast<int32_t>(values_.size());
+      codes_.emplace(std::string_view(copy, value.size()), code);
+      values_.data_.append(value.data(), value.size());
+      values_.offsets_.push_back(static_cast<int64_t>(values_.data_.size()));
+      return code;
+    }
+
+    size_t size() const {
+      return values_.size();
+    }
+
+    // The values interned so far. The copy is shared with earlier 
+    // snapshots until a new value is added
+    std::shared_ptr<const Dictionary> snapshot() {
+      if (!snapshot_ || snapshot_->size() != values_.size())
+        snapshot_ = std::make_shared<const Dictionary>(values_);
+      return snapshot_;
+    }
+
+  private:
+    Arena arena_;
+    unordered_flat_map<std::string_view, int32_t> codes_;
+    Dictionary values_;
+    std::shared_ptr<const Dictionary> snapshot_;
+  };
+
+  // One column of a RecordBatch. Values are stored contiguously by type:
+  //  - Type::string: the bytes of all values back to back in data(), and
+  //    size() + 1 offsets(); value i is data()[offsets()[i], offsets()[i + 1])
+  //  - Type::int64, Type::decimal (unscaled) and Type::timestamp 
+  //    (nanoseconds): integers()
+  //  - Type::float64: floats()
+  //  - Type::boolean: one bit per value in booleans()
+  //  - Type::dictionary: an int32_t code per value in codes(), which 
+  //    indexes dictionary(). Codes are the same in every batch of a file
+  // validity() has a 0 bit for every null. Values that don't convert to
+  // the column type are null too
+  class Column {
+  public:
+    Column(const std::string& name, ColumnType type, std::shared_ptr<DictionaryBuilder> builder = nullptr) :
+      name_(name),
+      type_(type),
+      size_(0),
+      null_count_(0),
+      builder_(std::move(builder)) {
+      if (type_.type == Type::string)
+        offsets_.push_back(0);
+      if (type_.type == Type::dictionary && !builder_)
+        builder_ = std::make_shared<DictionaryBuilder>();
+    }
+
+    const std::string& name() const {
+      return name_;
+    }
+
+    ColumnType type() const {
+      return type_;
+    }
+
+    size_t size() const {
+      return size_;
+    }
+
+    size_t null_count() const {
+      return null_count_;
+    }
+
+    bool is_null(size_t index) const {
+      return !validity_.test(index);
+    }
+
+    std::string_view string(size_t index) const {
+      if (type_.type == Type::dictionary)
+        return dictionary_->value(codes_[index]);
+      return std::string_view(data_.data() + offsets_[index],
+        static_cast<size_t>(offsets_[index + 1] - offsets_[index]));
+    }
+
+    int64_t int64(size_t index) const {
+      return integers_[index];
+    }
+
+    double float64(size_t index) const {
+      return floats_[index];
+    }
+
+    bool boolean(size_t index) const {
+      return booleans_.test(index);
+    }
+
+    Decimal decimal(size_t index) const {
+      return Decimal{ integers_[index], type_.scale };
+    }
+
+    Timestamp timestamp(size_t index) const {
+      return Timestamp{ integers_[index] };
+    }
+
+    const Bitmap& validity() const {
+      return validity_;
+    }
+
+    const std::vector<int64_t>& offsets() const {
+      return offsets_;
+    }
+
+    const std::string& data() const {
+      return data_;
+    }
+
+    const std::vector<int64_t>& integers() const {
+      return integers_;
+    }
+
+    const std::vector<double>& floats() const {
+      return floats_;
+    }
+
+    const Bitmap& booleans() const {
+      return booleans_;
+    }
+
+    int32_t code(size_t index) const {
+      return codes_[index];
+    }
+
+    const std::vector<int32_t>& codes() const {
+      return codes_;
+    }
+
+    // Values of a Type::dictionary column, see RecordBatch::finish()
+    const Dictionary& dictionary() const {
+      return *dictionary_;
+    }
+
+    std::shared_ptr<const Dictionary> shared_dictionary() const {
+      return dictionary_;
+    }
+
+    // Remove all values but keep the memory, for reuse in another batch
+    void clear() {
+      size_ = 0;
+      null_count_ = 0;
+      validity_.clear();
+      offsets_.clear();
+      if (type_.type == Type::string)
+        offsets_.push_back(0);
+      data_.clear();
+      integers_.clear();
+      floats_.clear();
+      booleans_.clear();
+      codes_.clear();
+      dictionary_.reset();
+    }
+
+    // Take a snapshot of the dictionary once the column is complete
+    void finish() {
+      if (type_.type == Type::dictionary)
+        dictionary_ = builder_->snapshot();
+    }
+
+    void reserve(size_t rows) {
+      validity_.reserve(rows);
+      switch (type_.type) {
+      case Type::string:
+        offsets_.reserve(rows + 1);
+        break;
+      case Type::float64:
+        floats_.reserve(rows);
+        break;
+      case Type::boolean:
+        booleans_.reserve(rows);
+        break;
+      case Type::dictionary:
+        codes_.reserve(rows);
+        break;
+      default:
+        integers_.reserve(rows);
+        break;
+      }
+    }
+
+    // Add a value at the end. Fields of typed columns are converted here,
+    // without the quote characters around them
+    void append(std::string_view field, bool valid, char quote_character) {
+      switch (type_.type) {
+      case Type::string:
+        if (valid)
+          data_.append(field.data(), field.size());
+        offsets_.push_back(static_cast<int64_t>(data_.size()));
+        break;
+      case Type::int64: {
+        int64_t value = 0;
+        valid = valid && parse_int64(strip_quotes(field, quote_character), value);
+        integers_.push_back(value);
+        break;
+      }
+      case Type::float64: {
+        double value = 0.0;
+        valid = valid && parse_double(strip_quotes(field, quote_character), value);
+        floats_.push_back(value);
+        break;
+      }
+      case Type::boolean: {
+        bool value = false;
+        valid = valid && parse_bool(strip_quotes(field, quote_character), value);
+        booleans_.push_back(value);
+        break;
+      }
+      case Type::decimal: {
+        int64_t value = 0;
+        valid = valid && parse_decimal(strip_quotes(field, quote_character), type_.scale, value);
+        integers_.push_back(value);
+        break;
+      }
+      case Type::timestamp: {
+        int64_t value = 0;
+        valid = valid && parse_timestamp(strip_quotes(field, quote_character), value);
+        integers_.push_back(value);
+        break;
+      }
+      case Type::dictionary:
+        // Null values get code 0, which is never looked at
+        codes_.push_back(valid ? builder_->intern(field) : 0);
+        break;
+      }
+      validity_.push_back(valid);
+      null_count_ += valid ? 0 : 1;
+      size_ += 1;
+    }
+
+  private:
+    std::string name_;
+    ColumnType type_;
+    size_t size_;
+    size_t null_count_;
+    Bitmap validity_;
+    std::vector<int64_t> offsets_;
+    std::string data_;
+    std::vector<int64_t> integers_;
+    std::vector<double> floats_;
+    Bitmap booleans_;
+    std::vector<int32_t> codes_;
+    std::shared_ptr<DictionaryBuilder> builder_;
+    std::shared_ptr<const Dictionary> dictionary_;
+  };
+
+  // A group of consecutive rows, stored column by column
+  // See Reader::record_batches()
+  class RecordBatch {
+  public:
+    RecordBatch() :
+      num_rows_(0),
+      position_{ 0, 0 } {}
+
+    size_t num_rows() const {
+      return num_rows_;
+    }
+
+    size_t num_columns() const {
+      return columns_.size();
+    }
+
+    const Column& column(size_t index) const {
+      return columns_[index];
+    }
+
+    const Column& column(const std::string& name) const {
+      for (auto& column : columns_)
+        if (column.name() == name)
+          return column;
+      throw std::runtime_error("error: Column " + name + " not found");
+    }
+
+    const std::vector<Column>& columns() const {
+      return columns_;
+    }
+
+    // Where the first row of the batch starts in the file
+    RowPosition position() const {
+      return position_;
+    }
+
+    // Dictionary columns intern their values with builder, which can be
+    // shared by the batches of a file so that codes stay the same
+    void add_column(const std::string& name, ColumnType type, size_t capacity,
+      std::shared_ptr<DictionaryBuilder> builder = nullptr) {
+      columns_.emplace_back(name, type, std::move(builder));
+      columns_.back().reserve(capacity);
+    }
+
+    // Remove all rows but keep the columns and their memory
+    void clear() {
+      num_rows_ = 0;
+      position_ = RowPosition{ 0, 0 };
+      for (auto& column : columns_)
+        column.clear();
+    }
+
+    // Called once the last row has been added
+    void finish() {
+      for (auto& column : columns_)
+        column.finish();
+    }
+
+    // Add a row. Column i gets fields[indices[i]], which is null if its
+    // bit in validity is 0. Without a validity bitmap, nothing is null
+    void append(const std::vector<std::string_view>& fields, const std::vector<size_t>& indices,
+      const Bitmap* validity, char quote_character, RowPosition position) {
+      if (num_rows_ == 0)
+        position_ = position;
+      for (size_t i = 0; i < columns_.size(); ++i) {
+        const size_t index = indices[i];
+        columns_[i].append(fields[index], validity == nullptr || validity->test(index), quote_character);
+      }
+      num_rows_ += 1;
+    }
+
+  private:
+    size_t num_rows_;
+    RowPosition position_;
+    std::vector<Column> columns_;
+  };
+
+}
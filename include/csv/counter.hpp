@@ -0,0 +1,293 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/dialect.hpp>
+#include <csv/encoding.hpp>
+#include <csv/framer.hpp>
+#include <csv/scanner.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace csv {
+
+  // Rows that start in a chunk of a file, for each state the chunk can
+  // start in: outside quotes, inside quotes or inside a comment line.
+  // rows[s] and state[s] are the rows and the state at the end of the 
+  // chunk if it starts in state s. Adding up the chunks in order picks
+  // the right one for each chunk
+  struct ChunkRows {
+    enum State : uint8_t { outside, quoted, comment };
+    size_t rows[3] = { 0, 0, 0 };
+    State state[3] = { outside, quoted, comment };
+  };
+
+  // Counts rows by looking at line breaks and quotes only, 16 bytes at a 
+  // time with SSE2. A row starts after every line break outside quotes, 
+  // unless it is a comment or, with skip_empty_rows, an empty row, which
+  // is what RowFramer and the reader make of the file too. Quotes in
+  // comment lines are ignored
+  // Only for "\n", "\r\n" and "\r" without an escape character
+  class RowCounter {
+  public:
+    explicit RowCounter(const Dialect& dialect) :
+      quote_character_(dialect.quote_character_),
+      comment_character_(dialect.comment_character_),
+      skip_empty_rows_(dialect.skip_empty_rows_) {}
+
+    static bool supports(const Dialect& dialect) {
+      const std::string& terminator = dialect.line_terminator_;
+      return dialect.escape_character_ == '\0' && dialect.encoding_ == Encoding::utf8 &&
+        (terminator == "\n" || terminator == "\r\n" || terminator == "\r" || terminator.empty());
+    }
+
+    // Whether a row that starts with ch is counted
+    bool counts(char ch) const {
+      if (comment_character_ != '\0' && ch == comment_character_)
+        return false;
+      return !(skip_empty_rows_ && (ch == '\n' || ch == '\r'));
+    }
+
+    // State of a row that starts with ch
+    ChunkRows::State state(char ch) const {
+      return comment_character_ != '\0' && ch == comment_character_ ? ChunkRows::comment : ChunkRows::outside;
+    }
+
+    // Count the rows starting after the line breaks in data[0, size)
+    // data[size] is the first byte after the chunk and must be readable.
+    // If at_end, it is past the end of the file and ignored
+    void count(const char* data, size_t size, bool at_end, ChunkRows& result) const {
+      // Without comments, a chunk never starts inside one
+      const size_t states = comment_character_ != '\0' ? 3 : 2;
+      size_t i = 0;
+#if defined(CSV_SCANNER_SSE2)
+      const __m128i quote = _mm_set1_epi8(quote_character_);
+      const __m128i comment = _mm_set1_epi8(comment_character_);
+      const __m128i line_feed = _mm_set1_epi8('\n');
+      const __m128i carriage_return = _mm_set1_epi8('\r');
+      for (; i + 16 < size; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+
+        // Blocks in or starting a comment line go one byte at a time
+        if (comment_character_ != '\0' &&
+          (_mm_movemask_epi8(_mm_cmpeq_epi8(next, comment)) != 0 ||
+            std::find(result.state, result.state + states, ChunkRows::comment) != result.state + states)) {
+          for (size_t s = 0; s < states; ++s)
+            count(data, i, i + 16, size, at_end, result.rows[s], result.state[s]);
+          continue;
+        }
+
+        uint32_t quotes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, quote)));
+        uint32_t line_feeds = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, line_feed)));
+        uint32_t carriage_returns = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, carriage_return)));
+        uint32_t next_line_feeds = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(next, line_feed)));
+
+        // A '\r' followed by '\n' is counted at the '\n'
+        uint32_t breaks = line_feeds | (carriage_returns & ~next_line_feeds);
+        if (breaks != 0) {
+          uint32_t skipped = 0;
+          if (skip_empty_rows_)
+            skipped |= next_line_feeds |
+              static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(next, carriage_return)));
+          uint32_t starts = breaks & ~skipped;
+
+          // Bit j is set if an odd number of quotes precede byte j
+          uint32_t inside = quotes;
+          inside ^= inside << 1;
+          inside ^= inside << 2;
+          inside ^= inside << 4;
+          inside ^= inside << 8;
+          for (size_t s = 0; s < states; ++s) {
+            uint32_t quoted = result.state[s] == ChunkRows::quoted ? ~inside : inside;
+            result.rows[s] += popcount(starts & ~quoted & 0xFFFF);
+          }
+        }
+        if (popcount(quotes) & 1)
+          for (size_t s = 0; s < states; ++s)
+            result.state[s] = result.state[s] == ChunkRows::quoted ? ChunkRows::outside : ChunkRows::quoted;
+      }
+#endif
+      for (size_t s = 0; s < states; ++s)
+        count(data, i, size, size, at_end, result.rows[s], result.state[s]);
+    }
+
+  private:
+    // Count the rows starting after the line breaks in data[begin, end),
+    // one byte at a time, for a chunk in state
+    void count(const char* data, size_t begin, size_t end, size_t size, bool at_end,
+      size_t& rows, ChunkRows::State& state) const {
+      for (size_t i = begin; i < end; ++i) {
+        const char ch = data[i];
+        if (ch == quote_character_ && state != ChunkRows::comment) {
+          state = state == ChunkRows::quoted ? ChunkRows::outside : ChunkRows::quoted;
+          continue;
+        }
+        if ((ch != '\n' && ch != '\r') || state == ChunkRows::quoted)
+          continue;
+        if (i + 1 == size && at_end)
+          break;
+        const char next = data[i + 1];
+        if (ch == '\r' && next == '\n')
+          continue;
+        state = this->state(next);
+        if (counts(next))
+          rows += 1;
+      }
+    }
+
+    char quote_character_;
+    char comment_character_;
+    bool skip_empty_rows_;
+  };
+
+  // Count the rows of a stream one row at a time with RowFramer
+  // Works for every dialect; see count_rows(filename, dialect) for details
+  inline size_t count_rows(std::istream& stream, const Dialect& dialect) {
+    std::unique_ptr<TranscodingBuffer> transcoder;
+    std::unique_ptr<std::istream> transcoded;
+    if (dialect.encoding_ != Encoding::utf8) {
+      transcoder = std::make_unique<TranscodingBuffer>(stream, dialect.encoding_);
+      transcoded = std::make_unique<std::istream>(transcoder.get());
+    }
+
+    RowFramer framer(transcoded ? *transcoded : stream, dialect);
+    std::string_view row;
+    size_t line_number = 0;
+    size_t rows = 0;
+    while (framer.next(row)) {
+      if (line_number++ < dialect.skip_lines_ ||
+        (dialect.comment_character_ != '\0' && row.size() > 0 && row[0] == dialect.comment_character_))
+        continue;
+      if (row != "" || !dialect.skip_empty_rows_)
+        ++rows;
+    }
+    if (dialect.header_ && rows > 0)
+      rows -= 1;
+    return rows;
+  }
+
+  // Number of rows the reader produces for filename with dialect, without
+  // the preamble, the header, comment lines and, with skip_empty_rows, 
+  // empty rows. Line breaks inside quotes don't end a row
+  // The file is split into chunks that are counted on up to threads
+  // threads (0 = one per core). A chunk counts its rows for both quote 
+  // states it could start in, so the chunks don't depend on each other
+  inline size_t count_rows(const std::string& filename, const Dialect& dialect = Dialect(), size_t threads = 0) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("error: Failed to open " + filename);
+    if (!RowCounter::supports(dialect))
+      return count_rows(stream, dialect);
+
+    stream.seekg(0, std::ios::end);
+    const size_t file_size = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, std::ios::beg);
+
+    // Find the first row after the byte order mark and the preamble
+    size_t begin = 0;
+    {
+      RowFramer framer(stream, dialect);
+      std::string_view row;
+      for (size_t i = 0; i < dialect.skip_lines_; ++i)
+        framer.next(row);
+      if (!framer.next(row))
+        return 0;
+      begin = framer.row_offset();
+    }
+
+    RowCounter counter(dialect);
+    char first;
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(begin), std::ios::beg);
+    stream.get(first);
+    size_t rows = counter.counts(first) ? 1 : 0;
+    ChunkRows::State state = counter.state(first);
+
+    const size_t min_chunk_size = 1 << 20;
+    const size_t piece_size = 1 << 20;
+    if (threads == 0)
+      threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, (file_size - begin) / min_chunk_size));
+    const size_t chunk_size = (file_size - begin + threads - 1) / threads;
+
+    std::vector<ChunkRows> chunks(threads);
+    std::atomic<bool> failed(false);
+    auto count_chunk = [&](size_t index) {
+      size_t chunk_begin = begin + index * chunk_size;
+      size_t chunk_end = std::min(file_size, chunk_begin + chunk_size);
+      std::ifstream input(filename, std::ios::binary);
+      input.seekg(static_cast<std::streamoff>(chunk_begin), std::ios::beg);
+
+      // Each piece is read with one byte of the next so line breaks at
+      // the end can be classified, plus zero padding for the 16 byte loads
+      std::vector<char> buffer(piece_size + 1 + 16, '\0');
+      for (size_t position = chunk_begin; position < chunk_end; position += piece_size) {
+        size_t size = std::min(piece_size, chunk_end - position);
+        size_t wanted = std::min(size + 1, file_size - position);
+        input.seekg(static_cast<std::streamoff>(position), std::ios::beg);
+        input.read(buffer.data(), static_cast<std::streamsize>(wanted));
+        if (static_cast<size_t>(input.gcount()) != wanted) {
+          failed = true;
+          return;
+        }
+        std::fill(buffer.begin() + static_cast<std::ptrdiff_t>(wanted), buffer.end(), '\0');
+        counter.count(buffer.data(), size, position + size == file_size, chunks[index]);
+      }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i)
+      workers.emplace_back(count_chunk, i);
+    count_chunk(0);
+    for (auto& worker : workers)
+      worker.join();
+    if (failed)
+      throw std::runtime_error("error: Failed to read " + filename);
+
+    for (auto& chunk : chunks) {
+      rows += chunk.rows[state];
+      state = chunk.state[state];
+    }
+
+    if (dialect.header_ && rows > 0)
+      rows -= 1;
+    return rows;
+  }
+
+}
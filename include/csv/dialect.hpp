@@ -31,35 +31,62 @@ SOFTWARE.
 */
 #pragma once
 #include <csv/robin_hood.hpp>
+#include <csv/types.hpp>
+#include <csv/encoding.hpp>
 #include <string>
 #include <vector>
 #include <string_view>
 
 namespace csv {
 
+  // What the reader does with a malformed row, i.e., a row with the wrong
+  // number of fields or, when validating, invalid UTF-8
+  enum class ErrorPolicy {
+    permissive,   // pad or truncate rows to the header; raise on invalid UTF-8
+    strict,       // raise a csv::ParseError on the first malformed row
+    skip,         // drop malformed rows
+    quarantine    // drop malformed rows and report them, see Reader::next_error()
+  };
+
   struct Dialect {
 
     std::string delimiter_;
     bool skip_initial_space_;
-    char line_terminator_;
+    std::string line_terminator_;
     char quote_character_;
     bool double_quote_;
+    char escape_character_;
     std::vector<char> trim_characters_;
     bool header_;
     bool skip_empty_rows_;
+    char comment_character_;
+    size_t skip_lines_;
+    bool validate_utf8_;
+    Encoding encoding_;
+    ErrorPolicy error_policy_;
+    std::string quarantine_file_;
       
     unordered_flat_map<std::string_view, bool> ignore_columns_;
     std::vector<std::string> column_names_;
+    std::vector<std::string> null_values_;
+    unordered_flat_map<std::string, ColumnType> column_types_;
 
     Dialect() :
       delimiter_(","),
       skip_initial_space_(false),
-      line_terminator_('\n'),
+      line_terminator_("\n"),
       quote_character_('"'),
       double_quote_(true),
+      escape_character_('\0'),
       trim_characters_({}),
       header_(true),
-      skip_empty_rows_(false) {}
+      skip_empty_rows_(false),
+      comment_character_('\0'),
+      skip_lines_(0),
+      validate_utf8_(false),
+      encoding_(Encoding::utf8),
+      error_policy_(ErrorPolicy::permissive),
+      quarantine_file_("") {}
 
     Dialect& delimiter(const std::string& delimiter) {
       delimiter_ = delimiter;
@@ -76,6 +103,50 @@ namespace csv {
       return *this;
     }
 
+    // Lines starting with this character are skipped. '\0' disables comments
+    Dialect& comment_character(char comment_character) {
+      comment_character_ = comment_character;
+      return *this;
+    }
+
+    // Skip a preamble of skip_lines lines before the header
+    Dialect& skip_lines(size_t skip_lines) {
+      skip_lines_ = skip_lines;
+      return *this;
+    }
+
+    // "\n", "\r\n" and "\r" are interchangeable when reading: any of the 
+    // three ends a row. Other terminators have to match exactly
+    Dialect& line_terminator(const std::string& line_terminator) {
+      line_terminator_ = line_terminator;
+      return *this;
+    }
+
+    // Check that every row is valid UTF-8 while reading
+    Dialect& validate_utf8(bool validate_utf8) {
+      validate_utf8_ = validate_utf8;
+      return *this;
+    }
+
+    // Encoding of the file. Anything other than UTF-8 is transcoded to
+    // UTF-8 before it reaches the tokenizer
+    Dialect& encoding(Encoding encoding) {
+      encoding_ = encoding;
+      return *this;
+    }
+
+    Dialect& error_policy(ErrorPolicy error_policy) {
+      error_policy_ = error_policy;
+      return *this;
+    }
+
+    // Also append quarantined rows to this file, as offset,line,reason,row
+    // with reason and row in quotes
+    Dialect& quarantine_file(const std::string& quarantine_file) {
+      quarantine_file_ = quarantine_file;
+      return *this;
+    }
+
     Dialect& quote_character(char quote_character) {
       quote_character_ = quote_character;
       return *this;
@@ -86,6 +157,13 @@ namespace csv {
       return *this;
     }
 
+    // The character that makes the next character lose any special meaning,
+    // e.g., '\\' for MySQL and Postgres dumps. '\0' disables escaping
+    Dialect& escape_character(char escape_character) {
+      escape_character_ = escape_character;
+      return *this;
+    }
+
     // Base case for trim_characters parameter packing
     Dialect& trim_characters() {
       return *this;
@@ -114,6 +192,21 @@ namespace csv {
       return *this;
     }
 
+    // Base case for null_values parameter packing
+    Dialect& null_values() {
+      return *this;
+    }
+
+    // Parameter packed null_values method
+    // Accepts a variadic number of tokens that stand for a missing value,
+    // e.g., "NA", "NULL", "\\N" or ""
+    template<typename T, typename... Targs>
+    Dialect& null_values(T token, Targs... Fargs) {
+      null_values_.push_back(token);
+      null_values(Fargs...);
+      return *this;
+    }
+
     // Base case for ignore_columns parameter packing
     Dialect& column_names() {
       return *this;
@@ -149,6 +242,14 @@ namespace csv {
       header_ = header;
       return *this;
     }
+
+    // Declare the type of a column. Values in typed columns are converted 
+    // on the reading thread, see Reader::next_typed_row() and Row::value()
+    // scale is the number of digits after the decimal point for Type::decimal
+    Dialect& column_type(const std::string& column, Type type, int scale = 0) {
+      column_types_[column] = ColumnType{ type, scale };
+      return *this;
+    }
   };
 
 }
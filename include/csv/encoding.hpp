@@ -0,0 +1,321 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/scanner.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+#include <string>
+
+namespace csv {
+
+  // Encodings the reader can transcode to UTF-8 on the fly
+  enum class Encoding {
+    utf8,
+    utf16le,
+    utf16be,
+    latin1,
+    windows1252
+  };
+
+  // Position of the first byte that isn't part of a valid UTF-8 sequence,
+  // or size if all of data is valid UTF-8
+  // Runs of ASCII are skipped 16 bytes at a time with SSE2 (8 bytes at a 
+  // time otherwise); only multi-byte sequences are decoded byte by byte
+  inline size_t validate_utf8(const char* data, size_t size) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < size) {
+#if defined(CSV_SCANNER_SSE2)
+      while (i + 16 <= size &&
+        _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i))) == 0)
+        i += 16;
+#endif
+      while (i + 8 <= size) {
+        uint64_t chunk;
+        std::memcpy(&chunk, bytes + i, sizeof(chunk));
+        if (chunk & 0x8080808080808080ULL)
+          break;
+        i += 8;
+      }
+      while (i < size && bytes[i] < 0x80)
+        i += 1;
+      if (i == size)
+        break;
+
+      // Lead byte, then the valid range of the first continuation byte
+      const unsigned char lead = bytes[i];
+      size_t length;
+      unsigned char low = 0x80, high = 0xBF;
+      if (lead >= 0xC2 && lead <= 0xDF)
+        length = 2;
+      else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) low = 0xA0;        // overlong
+        else if (lead == 0xED) high = 0x9F;  // surrogates
+      }
+      else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) low = 0x90;        // overlong
+        else if (lead == 0xF4) high = 0x8F;  // beyond U+10FFFF
+      }
+      else
+        return i;
+
+      if (i + length > size || bytes[i + 1] < low || bytes[i + 1] > high)
+        return i;
+      for (size_t j = 2; j < length; ++j)
+        if (bytes[i + j] < 0x80 || bytes[i + j] > 0xBF)
+          return i;
+      i += length;
+    }
+    return size;
+  }
+
+  // Append the UTF-8 encoding of code_point to output
+  inline char* encode_utf8(uint32_t code_point, char* output) {
+    if (code_point < 0x80) {
+      *output++ = static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800) {
+      *output++ = static_cast<char>(0xC0 | (code_point >> 6));
+      *output++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000) {
+      *output++ = static_cast<char>(0xE0 | (code_point >> 12));
+      *output++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      *output++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else {
+      *output++ = static_cast<char>(0xF0 | (code_point >> 18));
+      *output++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      *output++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      *output++ = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    return output;
+  }
+
+  // Transcode Latin-1 or Windows-1252 to UTF-8. Writes at most 3 * size bytes
+  // and returns the end of the output
+  inline char* single_byte_to_utf8(const char* data, size_t size, char* output, bool windows1252) {
+    // Windows-1252 differs from Latin-1 in 0x80-0x9F. Unassigned bytes map 
+    // to the C1 control with the same value, as in the WHATWG encoding spec
+    static const uint16_t windows1252_high[32] = {
+      0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+      0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+      0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+      0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+    };
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < size) {
+#if defined(CSV_SCANNER_SSE2)
+      // Copy runs of ASCII 16 bytes at a time
+      while (i + 16 <= size) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        if (_mm_movemask_epi8(block) != 0)
+          break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), block);
+        output += 16;
+        i += 16;
+      }
+      if (i == size)
+        break;
+#endif
+      const unsigned char byte = bytes[i++];
+      if (byte < 0x80)
+        *output++ = static_cast<char>(byte);
+      else if (windows1252 && byte < 0xA0)
+        output = encode_utf8(windows1252_high[byte - 0x80], output);
+      else
+        output = encode_utf8(byte, output);
+    }
+    return output;
+  }
+
+  // Transcode UTF-16 to UTF-8. Writes at most 3 * size / 2 bytes
+  // Unpaired surrogates become U+FFFD. Returns the number of input bytes 
+  // consumed; a trailing odd byte or a high surrogate whose pair is cut 
+  // off is left for the next call, unless this is the last block
+  inline size_t utf16_to_utf8(const char* data, size_t size, char*& output, bool big_endian, bool last_block) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    auto unit = [&](size_t i) -> uint32_t {
+      return big_endian ? (uint32_t(bytes[i]) << 8) | bytes[i + 1] : (uint32_t(bytes[i + 1]) << 8) | bytes[i];
+    };
+    size_t i = 0;
+    while (i + 2 <= size) {
+#if defined(CSV_SCANNER_SSE2)
+      // 8 code units below 0x80 are packed into 8 bytes at once
+      while (i + 16 <= size) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        if (big_endian)
+          block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+        __m128i non_ascii = _mm_and_si128(block, _mm_set1_epi16(static_cast<short>(0xFF80)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, _mm_setzero_si128())) != 0xFFFF)
+          break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(block, block));
+        output += 8;
+        i += 16;
+      }
+      if (i + 2 > size)
+        break;
+#endif
+      uint32_t code_point = unit(i);
+      if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+        if (i + 4 > size && !last_block)
+          return i;
+        uint32_t low = (i + 4 <= size) ? unit(i + 2) : 0;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          i += 2;
+        }
+        else
+          code_point = 0xFFFD;
+      }
+      else if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+        code_point = 0xFFFD;
+      output = encode_utf8(code_point, output);
+      i += 2;
+    }
+    if (last_block && i < size) {
+      output = encode_utf8(0xFFFD, output);
+      i = size;
+    }
+    return i;
+  }
+
+  // Number of bytes of text in encoding that were transcoded to data, a
+  // run of whole UTF-8 sequences. UTF-16 takes two bytes for code points
+  // in the basic plane and four for the others
+  inline size_t source_size(const char* data, size_t size, Encoding encoding) {
+    if (encoding == Encoding::utf8)
+      return size;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const bool utf16 = encoding == Encoding::utf16le || encoding == Encoding::utf16be;
+    size_t result = 0;
+    for (size_t i = 0; i < size; ++i) {
+      if ((bytes[i] & 0xC0) == 0x80)
+        continue;
+      result += !utf16 ? 1 : (bytes[i] >= 0xF0 ? 4 : 2);
+    }
+    return result;
+  }
+
+  // A pipeline stage that reads another stream one block at a time and
+  // hands out its contents transcoded to UTF-8
+  // A byte order mark matching the encoding is skipped
+  class TranscodingBuffer : public std::streambuf {
+  public:
+    TranscodingBuffer(std::istream& source, Encoding encoding, size_t block_size = 1 << 16) :
+      source_(source),
+      encoding_(encoding),
+      input_(block_size > 4 ? block_size : 4, '\0'),
+      pending_(0),
+      output_(3 * input_.size() + 4, '\0'),
+      started_(false),
+      byte_order_mark_size_(0),
+      eof_(false) {}
+
+    Encoding encoding() const {
+      return encoding_;
+    }
+
+    // Bytes skipped at the start of the source, once reading has started
+    size_t byte_order_mark_size() const {
+      return byte_order_mark_size_;
+    }
+
+  protected:
+    int_type underflow() override {
+      if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+      char* output_begin = &output_[0];
+      char* output = output_begin;
+      while (output == output_begin && !(eof_ && pending_ == 0)) {
+        source_.read(&input_[pending_], static_cast<std::streamsize>(input_.size() - pending_));
+        size_t size = pending_ + static_cast<size_t>(source_.gcount());
+        if (!source_)
+          eof_ = true;
+
+        size_t start = 0;
+        if (!started_ && (size >= 2 || eof_)) {
+          started_ = true;
+          if (size >= 2 && ((encoding_ == Encoding::utf16le && input_[0] == '\xFF' && input_[1] == '\xFE') ||
+            (encoding_ == Encoding::utf16be && input_[0] == '\xFE' && input_[1] == '\xFF')))
+            start = 2;
+          byte_order_mark_size_ = start;
+        }
+
+        size_t consumed = size;
+        switch (encoding_) {
+        case Encoding::utf16le:
+        case Encoding::utf16be:
+          consumed = start + utf16_to_utf8(input_.data() + start, size - start, output,
+            encoding_ == Encoding::utf16be, eof_);
+          break;
+        case Encoding::latin1:
+        case Encoding::windows1252:
+          output = single_byte_to_utf8(input_.data(), size, output, encoding_ == Encoding::windows1252);
+          break;
+        default:
+          std::memcpy(output, input_.data(), size);
+          output += size;
+          break;
+        }
+
+        // Keep a partial code unit or surrogate pair for the next block
+        pending_ = size - consumed;
+        if (pending_ > 0)
+          std::memmove(&input_[0], &input_[consumed], pending_);
+      }
+
+      setg(output_begin, output_begin, output);
+      if (output == output_begin)
+        return traits_type::eof();
+      return traits_type::to_int_type(*gptr());
+    }
+
+  private:
+    std::istream& source_;
+    Encoding encoding_;
+    std::string input_;
+    size_t pending_;
+    std::string output_;
+    bool started_;
+    size_t byte_order_mark_size_;
+    bool eof_;
+  };
+
+}
@@ -0,0 +1,278 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/dialect.hpp>
+#include <csv/encoding.hpp>
+#include <csv/scanner.hpp>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+
+namespace csv {
+
+  // Where a row starts in the file. Line breaks inside quoted values
+  // count, so line is the physical line number, starting at 1. offset is
+  // in bytes of the file, also when it is transcoded to UTF-8
+  struct RowPosition {
+    size_t offset;
+    size_t line;
+  };
+
+  // Splits a stream into rows, reading it one block at a time
+  // If the dialect's line terminator is "\n", "\r\n" or "\r", any of the 
+  // three ends a row. Any other terminator has to match exactly
+  // Terminators inside quotes, or right after the escape character, are
+  // part of the row. A UTF-8 byte order mark at the start is skipped
+  // Physical lines are counted on the way, including the line breaks
+  // inside quoted values, so every row knows the line it starts on
+  // Preamble lines (see Dialect::skip_lines()) and comment lines end at
+  // the next terminator: quotes and escapes in them mean nothing
+  class RowFramer {
+  public:
+    RowFramer(std::istream& stream, const Dialect& dialect, size_t block_size = 1 << 16) :
+      stream_(stream),
+      buffer_(block_size > 0 ? block_size : 1, '\0'),
+      begin_(0),
+      end_(0),
+      eof_(false),
+      consumed_(0),
+      row_offset_(0),
+      line_(1),
+      row_line_(1),
+      started_(false),
+      terminator_(dialect.line_terminator_),
+      universal_newlines_(terminator_ == "\n" || terminator_ == "\r\n" || terminator_ == "\r" || terminator_.empty()),
+      quote_character_(dialect.quote_character_),
+      escape_character_(dialect.escape_character_),
+      comment_character_(dialect.comment_character_),
+      skip_lines_(dialect.skip_lines_),
+      rows_(0),
+      transcoder_(nullptr),
+      source_offset_(0) {
+      if (universal_newlines_) {
+        scanner_.add('\n');
+        scanner_.add('\r');
+      }
+      else {
+        scanner_.add(terminator_[0]);
+        scanner_.add('\n');
+      }
+      scanner_.add(quote_character_);
+      if (escape_character_ != '\0')
+        scanner_.add(escape_character_);
+    }
+
+    // Report row offsets in bytes of the stream transcoder reads from,
+    // when framing its UTF-8 output. Call before next()
+    void map_offsets(const TranscodingBuffer& transcoder) {
+      transcoder_ = &transcoder;
+    }
+
+    // Get the next row, without its terminator
+    // The view is valid until the next call
+    bool next(std::string_view& row) {
+      size_t position = begin_;
+      if (!started_) {
+        started_ = true;
+        while (!eof_ && end_ < 3)
+          refill(position);
+        if (end_ >= 3 && std::memcmp(buffer_.data(), "\xEF\xBB\xBF", 3) == 0)
+          begin_ = 3;
+        position = begin_;
+        if (transcoder_)
+          source_offset_ = transcoder_->byte_order_mark_size() +
+            source_size(buffer_.data(), begin_, transcoder_->encoding());
+      }
+      if (begin_ == end_) {
+        if (!eof_)
+          refill(position);
+        if (begin_ == end_)
+          return false;
+      }
+      const size_t row_start = consumed_ + begin_;
+      row_offset_ = transcoder_ ? source_offset_ : row_start;
+      row_line_ = line_;
+
+      const bool literal = rows_ < skip_lines_ ||
+        (comment_character_ != '\0' && buffer_[begin_] == comment_character_);
+      rows_ += 1;
+
+      bool quoted = false;
+      while (true) {
+        position = scanner_.find(buffer_.data(), end_, position);
+        if (position == end_) {
+          if (eof_) {
+            // Last row, without a terminator
+            row = std::string_view(buffer_.data() + begin_, end_ - begin_);
+            begin_ = end_;
+            advance_source(row_start);
+            return true;
+          }
+          refill(position);
+          continue;
+        }
+
+        const char ch = buffer_[position];
+        if (literal && ch != '\n' && ch != '\r' && ch != terminator_[0]) {
+          position += 1;
+          continue;
+        }
+
+        if (ch == escape_character_ && escape_character_ != '\0') {
+          if (position + 1 == end_ && !eof_) {
+            refill(position);
+            continue;
+          }
+          if (position + 1 < end_ && buffer_[position + 1] == '\n')
+            line_ += 1;
+          position += 2;
+          continue;
+        }
+
+        if (ch == quote_character_) {
+          quoted = !quoted;
+          position += 1;
+          continue;
+        }
+
+        if (quoted) {
+          // A '\r\n' is one line break, counted at the '\n'
+          if (ch == '\r' && position + 1 == end_ && !eof_) {
+            refill(position);
+            continue;
+          }
+          if (ch == '\n' || (ch == '\r' && (position + 1 == end_ || buffer_[position + 1] != '\n')))
+            line_ += 1;
+          position += 1;
+          continue;
+        }
+
+        if (universal_newlines_) {
+          // '\r' might be the first half of a '\r\n' in the next block
+          if (ch == '\r' && position + 1 == end_ && !eof_) {
+            refill(position);
+            continue;
+          }
+          size_t row_end = position;
+          position += (ch == '\r' && position + 1 < end_ && buffer_[position + 1] == '\n') ? 2 : 1;
+          row = std::string_view(buffer_.data() + begin_, row_end - begin_);
+          begin_ = position;
+          line_ += 1;
+          advance_source(row_start);
+          return true;
+        }
+
+        if (end_ - position < terminator_.size() && !eof_) {
+          refill(position);
+          continue;
+        }
+        if (std::string_view(buffer_.data() + position, end_ - position).substr(0, terminator_.size()) == terminator_) {
+          row = std::string_view(buffer_.data() + begin_, position - begin_);
+          begin_ = position + terminator_.size();
+          line_ += static_cast<size_t>(std::count(terminator_.begin(), terminator_.end(), '\n'));
+          advance_source(row_start);
+          return true;
+        }
+        if (ch == '\n')
+          line_ += 1;
+        position += 1;
+      }
+    }
+
+    // Byte offset in the stream of the start of the last row
+    size_t row_offset() const {
+      return row_offset_;
+    }
+
+    // Line number, starting at 1, of the start of the last row
+    size_t row_line() const {
+      return row_line_;
+    }
+
+  private:
+    // Move the unconsumed bytes to the front of the buffer and read the 
+    // next block after them. position is adjusted to the moved bytes
+    // Move the source offset past the row that was just framed, which is
+    // still in the buffer right before begin_
+    void advance_source(size_t row_start) {
+      if (transcoder_) {
+        const size_t size = consumed_ + begin_ - row_start;
+        source_offset_ += source_size(buffer_.data() + begin_ - size, size, transcoder_->encoding());
+      }
+    }
+
+    void refill(size_t& position) {
+      size_t unconsumed = end_ - begin_;
+      if (begin_ > 0) {
+        consumed_ += begin_;
+        if (unconsumed > 0)
+          std::memmove(&buffer_[0], &buffer_[begin_], unconsumed);
+        position -= begin_;
+        begin_ = 0;
+        end_ = unconsumed;
+      }
+
+      // A row longer than the buffer
+      if (end_ == buffer_.size())
+        buffer_.resize(buffer_.size() * 2);
+
+      stream_.read(&buffer_[end_], static_cast<std::streamsize>(buffer_.size() - end_));
+      end_ += static_cast<size_t>(stream_.gcount());
+      if (!stream_)
+        eof_ = true;
+    }
+
+    std::istream& stream_;
+    std::string buffer_;
+    size_t begin_;
+    size_t end_;
+    bool eof_;
+    size_t consumed_;
+    size_t row_offset_;
+    size_t line_;
+    size_t row_line_;
+    bool started_;
+    std::string terminator_;
+    bool universal_newlines_;
+    char quote_character_;
+    char escape_character_;
+    char comment_character_;
+    size_t skip_lines_;
+    size_t rows_;             // rows framed so far, including the preamble
+    const TranscodingBuffer* transcoder_;
+    size_t source_offset_;    // where the next row starts in the source
+    Scanner scanner_;
+  };
+
+}
@@ -0,0 +1,164 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/dialect.hpp>
+#include <csv/encoding.hpp>
+#include <csv/framer.hpp>
+#include <csv/sniffer.hpp>
+#include <csv/tokenizer.hpp>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  // What peek() finds out about a file from its first few kilobytes
+  struct Peek {
+    std::vector<std::string> columns;
+    Dialect dialect;
+    size_t file_size;
+    size_t estimated_rows;    // exact if the whole file fit in the sample
+    bool exact;
+  };
+
+  // Parse the header and a sample of sample_bytes bytes of filename with 
+  // dialect, and estimate the number of rows from the file size and the
+  // average length of the sampled rows. Runs on the calling thread
+  inline Peek peek(const std::string& filename, const Dialect& dialect, size_t sample_bytes = 16384) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) {
+      throw std::runtime_error("error: Failed to open " + filename);
+    }
+    stream.seekg(0, std::ios::end);
+    const size_t file_size = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, std::ios::beg);
+
+    bool truncated;
+    const std::string raw_sample = read_sample(stream, sample_bytes, truncated);
+
+    std::istringstream raw_input(raw_sample);
+    std::unique_ptr<TranscodingBuffer> transcoder;
+    std::unique_ptr<std::istream> transcoded;
+    if (dialect.encoding_ != Encoding::utf8) {
+      transcoder = std::make_unique<TranscodingBuffer>(raw_input, dialect.encoding_);
+      transcoded = std::make_unique<std::istream>(transcoder.get());
+    }
+    std::istream& input = transcoded ? *transcoded : raw_input;
+
+    Peek result{ {}, dialect, file_size, 0, !truncated };
+    RowFramer framer(input, dialect);
+    Tokenizer tokenizer(dialect);
+    std::string_view row;
+    auto is_comment = [&](std::string_view line) {
+      return dialect.comment_character_ != '\0' && line.size() > 0 && line[0] == dialect.comment_character_;
+    };
+
+    for (size_t i = 0; i < dialect.skip_lines_; ++i)
+      framer.next(row);
+    bool has_first_line = false;
+    while ((has_first_line = framer.next(row)) && is_comment(row)) {}
+    if (!has_first_line)
+      return result;
+
+    // Same as the reader's columns
+    tokenizer.split(row);
+    const auto& fields = tokenizer.fields();
+    if (dialect.header_) {
+      result.columns.assign(fields.begin(), fields.end());
+    }
+    else if (dialect.column_names_.size() > 0) {
+      result.columns = dialect.column_names_;
+    }
+    else {
+      for (size_t i = 0; i < fields.size(); ++i)
+        result.columns.push_back(std::to_string(i));
+    }
+
+    // Rows after the header that are in the sample. The last one may have
+    // been cut off by the sample size, so it's left out unless the sample
+    // is the whole file
+    const size_t none = static_cast<size_t>(-1);
+    size_t body_begin = none;
+    size_t last_row_begin = none;
+    size_t text_size = framer.row_offset() + row.size();
+    bool last_row_counted = false;
+    size_t rows = 0;
+    if (!dialect.header_) {
+      body_begin = last_row_begin = framer.row_offset();
+      last_row_counted = true;
+      rows = 1;
+    }
+    while (framer.next(row)) {
+      if (body_begin == none)
+        body_begin = framer.row_offset();
+      last_row_begin = framer.row_offset();
+      text_size = last_row_begin + row.size();
+      last_row_counted = !is_comment(row) && !(row.empty() && dialect.skip_empty_rows_);
+      if (last_row_counted)
+        rows += 1;
+    }
+
+    if (!truncated) {
+      result.estimated_rows = rows;
+      return result;
+    }
+    if (body_begin == none) {
+      // Not even one row after the header made it into the sample
+      result.estimated_rows = file_size > raw_sample.size() ? 1 : 0;
+      return result;
+    }
+    if (last_row_counted)
+      rows -= 1;
+
+    // The sample might have been transcoded, so scale its lengths back to
+    // bytes of the file
+    const double scale = text_size > 0 ? static_cast<double>(raw_sample.size()) / text_size : 1.0;
+    const double remaining = static_cast<double>(file_size) - body_begin * scale;
+    if (rows == 0) {
+      result.estimated_rows = 1;
+      return result;
+    }
+    const double row_bytes = (last_row_begin - body_begin) * scale / rows;
+    result.estimated_rows = static_cast<size_t>(remaining / row_bytes + 0.5);
+    return result;
+  }
+
+  // Same as above, with the dialect sniffed from the sample
+  inline Peek peek(const std::string& filename, size_t sample_bytes = 16384) {
+    return peek(filename, sniff(filename, sample_bytes), sample_bytes);
+  }
+
+}
@@ -33,6 +33,13 @@ SOFTWARE.
 #include <csv/dialect.hpp>
 #include <csv/concurrent_queue.hpp>
 #include <csv/robin_hood.hpp>
+#include <csv/scanner.hpp>
+#include <csv/tokenizer.hpp>
+#include <csv/framer.hpp>
+#include <csv/encoding.hpp>
+#include <csv/counter.hpp>
+#include <csv/batch.hpp>
+#include <csv/row.hpp>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -46,9 +53,53 @@ SOFTWARE.
 #include <iterator>
 #include <atomic>
 #include <string_view>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <exception>
+#include <cstring>
+#include <new>
+#include <stdexcept>
 
 namespace csv {
 
+  // Raised on the reading thread when the file can't be parsed, and 
+  // rethrown to the consumer by busy(), done() and ready()
+  class ParseError : public std::runtime_error {
+  public:
+    ParseError(const std::string& message, size_t offset, size_t line = 0) :
+      std::runtime_error(message),
+      offset_(offset),
+      line_(line) {}
+
+    // Byte offset of the problem in the file
+    size_t offset() const {
+      return offset_;
+    }
+
+    // Line number, starting at 1, of the row with the problem
+    size_t line() const {
+      return line_;
+    }
+
+  private:
+    size_t offset_;
+    size_t line_;
+  };
+
+  // A row dropped under ErrorPolicy::quarantine
+  struct RowError {
+    size_t offset;        // byte offset of the start of the row
+    size_t line;          // line number of the start of the row
+    std::string reason;
+    std::string row;      // the row as it appears in the file
+  };
+
+  // Takes the fields of a row on the reading thread, see Reader::handle_rows().
+  // Returns false, with a reason in error, to reject a malformed row
+  using RowHandler = std::function<bool(const std::vector<std::string_view>& fields,
+    const Bitmap* validity, RowPosition position, std::string& error)>;
+
   class Reader {
   public:
     Reader() :
@@ -56,18 +107,20 @@ namespace csv {
       columns_(0),
       current_dialect_name_("excel"),
       reading_thread_started_(false),
-      processing_thread_started_(false),
-      row_iterator_index_(0),
       expected_number_of_rows_(0),
-      values_ptoken_(ProducerToken(values_)),
-      values_ctoken_(ConsumerToken(values_)),
+      counted_rows_(0),
       rows_ptoken_(ProducerToken(rows_)),
       rows_ctoken_(ConsumerToken(rows_)),
-      done_index_(0),
-      ready_index_(0),
-      next_index_(0),
+      typed_(false),
+      lazy_rows_(false),
+      has_pending_row_(false),
       ignore_columns_enabled_(false),
-      trimming_enabled_(false) {
+      number_of_rows_read_(0),
+      failed_(false),
+      number_of_bad_rows_(0),
+      batch_rows_(0),
+      batches_ctoken_(ConsumerToken(batches_)),
+      reading_finished_(false) {
 
       Dialect unix_dialect;
       unix_dialect
@@ -96,58 +149,253 @@ namespace csv {
 
     ~Reader() {
       if (reading_thread_started_) reading_thread_.join();
-      if (processing_thread_started_) processing_thread_.join();
     }
 
     bool busy() {
-      if (processing_thread_started_) {
-        row_iterator_queue_.try_dequeue(done_index_);
-        row_iterator_queue_.enqueue(done_index_);
-        bool result = (expected_number_of_rows_ == 0 || done_index_ + 1 == expected_number_of_rows_);
-        return !result;
+      return !done();
+    }
+
+    // Keep only the rows for which predicate returns true
+    // The predicate sees the raw field views of a row before anything is
+    // allocated for it, so rejected rows are never copied or queued.
+    // Multiple filters are combined with a logical AND
+    void filter(std::function<bool(const std::vector<std::string_view>&)> predicate) {
+      if (filter_) {
+        filter_ = [previous = std::move(filter_), predicate = std::move(predicate)]
+          (const std::vector<std::string_view>& fields) {
+          return previous(fields) && predicate(fields);
+        };
       }
-      else return true;
+      else filter_ = std::move(predicate);
     }
 
+    // Keep only the rows whose value in column satisfies predicate
+    // The column is resolved to an index once, on the first row. An unknown
+    // column stops the reading thread with an error
+    void filter(const std::string& column, std::function<bool(std::string_view)> predicate) {
+      filter([this, column, predicate = std::move(predicate), index = std::string::npos]
+        (const std::vector<std::string_view>& fields) mutable {
+        if (index == std::string::npos) {
+          auto it = std::find(headers_.begin(), headers_.end(), column);
+          if (it == headers_.end())
+            throw std::runtime_error("error: Column " + column + " not found");
+          index = static_cast<size_t>(it - headers_.begin());
+        }
+        return predicate(index < fields.size() ? fields[index] : std::string_view());
+      });
+    }
+
+    // True once the reading thread has finished and every row has been
+    // handed out
     bool done() {
-      if (processing_thread_started_) {
-        row_iterator_queue_.try_dequeue(done_index_);
-        row_iterator_queue_.enqueue(done_index_);
-        bool result = (expected_number_of_rows_ == 0 || done_index_ + 1 == expected_number_of_rows_);
-        return result;
-      }
-      else return false;
+      // Checked before the queue: the reading thread sets the flag after
+      // queuing its last row
+      if (!reading_finished_)
+        return false;
+      return !ready();
     }
 
+    // Whether a row can be taken without waiting. The row is taken off the
+    // queue here and kept until the next call to next_row() or next()
+    // If the reading thread failed, its error is rethrown once the rows
+    // it queued before have been handed out
     bool ready() {
-      size_t rows = 0;
-      number_of_rows_processed_.try_dequeue(rows);
-      row_iterator_queue_.try_dequeue(ready_index_);
-      bool result = (ready_index_ < expected_number_of_rows_ && ready_index_ < rows);
-      return result;
+      if (has_pending_row_)
+        return true;
+      const bool finished = reading_finished_;
+      has_pending_row_ = rows_.try_dequeue(rows_ctoken_, pending_row_);
+      if (!has_pending_row_ && finished)
+        rethrow_if_failed();
+      return has_pending_row_;
     }
 
     unordered_flat_map<std::string_view, std::string> next_row() {
-      row_iterator_queue_.enqueue(next_index_);
-      next_index_ += 1;
+      RowPosition position;
+      return next_row(position);
+    }
+
+    // Same as next_row(), and also tells where the row starts in the file
+    // The map is built from the next Row; null fields and ignored columns 
+    // are left out
+    unordered_flat_map<std::string_view, std::string> next_row(RowPosition& position) {
+      Row row;
+      next_queued_row(row);
+      position = row.position_;
       unordered_flat_map<std::string_view, std::string> result;
-      rows_.try_dequeue(rows_ctoken_, result);
+      for (size_t i : kept_columns_)
+        if (!row.is_null(i))
+          result.emplace(headers_[i], row[i]);
+      return result;
+    }
+
+    // The next row, with fields indexed like the columns of schema().
+    // Use instead of next_row() to skip building a map for every row:
+    //
+    //   auto price = reader.schema()->handle("price");
+    //   csv::Row row;
+    //   while (reader.next(row)) 
+    //     total += std::stod(std::string(row.get(price)));
+    //
+    // Blocks until a row is available and returns false once all rows 
+    // have been handed out
+    bool next(Row& row) {
+      while (!done()) {
+        if (ready()) {
+          next_queued_row(row);
+          return true;
+        }
+        std::this_thread::yield();
+      }
+      return false;
+    }
+
+    // Move up to max_rows rows into rows, replacing its contents. Waits 
+    // for at least one row and takes whatever else is queued at that point
+    // in one go, so the cost of synchronizing with the reading thread is 
+    // paid per batch instead of per row. Row objects already in rows are 
+    // reused. Returns false once all rows have been handed out
+    // max_rows must be at least 1
+    bool next_batch(std::vector<Row>& rows, size_t max_rows) {
+      if (max_rows == 0)
+        throw std::runtime_error("error: next_batch() needs max_rows > 0");
+      rows.resize(max_rows);
+      size_t count = 0;
+      if (has_pending_row_) {
+        rows[0] = std::move(pending_row_);
+        has_pending_row_ = false;
+        count = 1;
+      }
+      while (count < max_rows) {
+        count += rows_.try_dequeue_bulk(rows_ctoken_, rows.begin() + count, max_rows - count);
+        if (count > 0)
+          break;
+        if (reading_finished_) {
+          // The last rows might have been queued right before the flag
+          count = rows_.try_dequeue_bulk(rows_ctoken_, rows.begin(), max_rows);
+          break;
+        }
+        rethrow_if_failed();
+        std::this_thread::yield();
+      }
+      rows.resize(count);
+      if (count == 0)
+        rethrow_if_failed();
+      return count > 0;
+    }
+
+    // Column names and types, shared by all the rows of the file. Null 
+    // until the reading thread has parsed the header, see busy()
+    std::shared_ptr<const Schema> schema() const {
+      return std::atomic_load(&schema_);
+    }
+
+    // Emit RecordBatch objects with up to rows_per_batch rows each, laid 
+    // out column by column, instead of rows. Call before read() and get 
+    // the batches with next_record_batch()
+    void record_batches(size_t rows_per_batch = 65536) {
+      batch_rows_ = rows_per_batch;
+    }
+
+    // Wait for the next batch. Returns false once all batches have been
+    // handed out
+    bool next_record_batch(RecordBatch& batch) {
+      while (true) {
+        if (batches_.try_dequeue(batches_ctoken_, batch))
+          return true;
+        if (reading_finished_) {
+          // The last batch might have been queued right before the flag
+          if (batches_.try_dequeue(batches_ctoken_, batch))
+            return true;
+          rethrow_if_failed();
+          return false;
+        }
+        std::this_thread::yield();
+      }
+    }
+
+    // Only frame rows on the reading thread and hand out lazy Rows that
+    // keep the raw line, see Row::raw(). A lazy row is split the first 
+    // time one of its fields is read, and only up to that field. Rows are
+    // still split up front when a filter is set or the error policy checks
+    // the number of fields. Doesn't apply to record batches or typed 
+    // readers. Call before read()
+    void lazy_rows(bool enabled = true) {
+      lazy_rows_ = enabled;
+    }
+
+    // Give a batch back once you're done with it. The reading thread fills
+    // it again instead of allocating a new one, so that a consumer that
+    // recycles every batch reads the file without allocating after the
+    // first few batches
+    void recycle(RecordBatch&& batch) {
+      batch.clear();
+      free_batches_.enqueue(std::move(batch));
+    }
+
+    // Pass every row to on_row on the reading thread instead of queuing it.
+    // on_header gets the column names first and can throw to stop reading,
+    // e.g., when a column is missing. Rows rejected by on_row are handled
+    // like other malformed rows, see Dialect::error_policy(). This is how
+    // TypedReader converts fields without going through Row or maps.
+    // Call before read()
+    void handle_rows(std::function<void(const std::vector<std::string>&)> on_header, RowHandler on_row) {
+      header_handler_ = std::move(on_header);
+      row_handler_ = std::move(on_row);
+    }
+
+    // Whether the reading thread is done with the file, either at the end
+    // or because of an error, see rethrow_if_failed()
+    bool finished() const {
+      return reading_finished_;
+    }
+
+    // Rethrow the error that stopped the reading thread, if any
+    void rethrow_if_failed() {
+      if (failed_)
+        std::rethrow_exception(error_);
+    }
+
+    // Rows dropped under ErrorPolicy::quarantine, in file order, with
+    // their offset and the reason they were rejected. Returns false if 
+    // there is no such row at the moment
+    bool next_error(RowError& error) {
+      return errors_.try_dequeue(error);
+    }
+
+    // Number of malformed rows dropped so far under ErrorPolicy::skip or
+    // ErrorPolicy::quarantine
+    size_t bad_rows() const {
+      return number_of_bad_rows_;
+    }
+
+    // Use next_typed_row() instead of next_row() when the dialect 
+    // declares column types
+    unordered_flat_map<std::string_view, Value> next_typed_row() {
+      RowPosition position;
+      return next_typed_row(position);
+    }
+
+    unordered_flat_map<std::string_view, Value> next_typed_row(RowPosition& position) {
+      Row row;
+      next_queued_row(row);
+      position = row.position_;
+      unordered_flat_map<std::string_view, Value> result;
+      for (size_t i : kept_columns_)
+        if (!row.is_null(i))
+          result.emplace(headers_[i], row.value(i));
       return result;
     }
 
     void read(const std::string& filename, size_t rows) {
       current_dialect_ = dialects_[current_dialect_name_];
       filename_ = filename;
-      stream_ = std::ifstream(filename_);
+      stream_ = std::ifstream(filename_, std::ios::binary);
       if (!stream_.is_open()) {
         throw std::runtime_error("error: Failed to open " + filename_);
       }
 
       expected_number_of_rows_ = rows;
 
-      if (current_dialect_.trim_characters_.size() > 0)
-        trimming_enabled_ = true;
-
       if (current_dialect_.ignore_columns_.size() > 0)
         ignore_columns_enabled_ = true;
 
@@ -158,29 +406,15 @@ namespace csv {
     void read(const std::string& filename) {
       current_dialect_ = dialects_[current_dialect_name_];
       filename_ = filename;
-      stream_ = std::ifstream(filename_);
+      stream_ = std::ifstream(filename_, std::ios::binary);
       if (!stream_.is_open()) {
         throw std::runtime_error("error: Failed to open " + filename_);
       }
 
-      // new lines will be skipped unless we stop it from happening:    
-      stream_.unsetf(std::ios_base::skipws);
-      std::string line;
-      while (std::getline(stream_, line)) {
-        if (line.size() > 0 && line[line.size() - 1] == '\r')
-          line.pop_back();
-        if (line != "" || (!current_dialect_.skip_empty_rows_ && line == ""))
-          ++expected_number_of_rows_;
-      }
-
-      if (current_dialect_.header_ && expected_number_of_rows_ > 0)
-        expected_number_of_rows_ -= 1;
-
-      stream_.clear();
-      stream_.seekg(0, std::ios::beg);
-
-      if (current_dialect_.trim_characters_.size() > 0)
-        trimming_enabled_ = true;
+      // The file isn't scanned up front. The reading thread publishes the
+      // number of rows once it reaches the end of the file
+      expected_number_of_rows_ = unknown_number_of_rows;
+      counted_rows_ = unknown_number_of_rows;
 
       if (current_dialect_.ignore_columns_.size() > 0)
         ignore_columns_enabled_ = true;
@@ -225,14 +459,16 @@ namespace csv {
           rows.push_back(next_row());
         }
       }
+      return rows;
+    }
 
-      // Done but not really
-      while (rows.size() < expected_number_of_rows_) {
+    std::vector<unordered_flat_map<std::string_view, Value>> typed_rows() {
+      std::vector<unordered_flat_map<std::string_view, Value>> rows;
+      while (!done()) {
         if (ready()) {
-          rows.push_back(next_row());
+          rows.push_back(next_typed_row());
         }
       }
-      
       return rows;
     }
 
@@ -240,33 +476,165 @@ namespace csv {
       return headers_;
     }
 
+    // The number of rows is exact once the file has been read. Before that
+    // it is counted on demand, see csv::count_rows(), which doesn't know 
+    // about filters or malformed rows
     std::pair<size_t, size_t> shape() {
-      return { expected_number_of_rows_, columns_ };
+      size_t rows = expected_number_of_rows_;
+      if (rows == unknown_number_of_rows) {
+        if (counted_rows_ == unknown_number_of_rows)
+          counted_rows_ = count_rows(filename_, current_dialect_);
+        rows = counted_rows_;
+      }
+      return { rows, columns_ };
     }
 
   private:
-    bool front(std::string& value) {
-      return values_.try_dequeue(values_ctoken_, value);
+    // Take the row found by ready(), waiting for one if needed. Leaves row
+    // empty if there are no rows left
+    void next_queued_row(Row& row) {
+      while (!ready()) {
+        if (reading_finished_ && !ready()) {
+          row = Row();
+          return;
+        }
+        std::this_thread::yield();
+      }
+      row = std::move(pending_row_);
+      has_pending_row_ = false;
     }
 
-    void read_internal() {
-      // Get current position
-      std::streamoff length = stream_.tellg();
+    // The stream rows are framed from: the file itself or, for encodings
+    // other than UTF-8, a transcoding stage in front of it
+    std::istream& open_input() {
+      if (current_dialect_.encoding_ == Encoding::utf8)
+        return stream_;
+      transcoder_ = std::make_unique<TranscodingBuffer>(stream_, current_dialect_.encoding_);
+      transcoded_stream_ = std::make_unique<std::istream>(transcoder_.get());
+      return *transcoded_stream_;
+    }
 
-      // Get first line and find headers by splitting on delimiters
-      std::string first_line;
-      getline(stream_, first_line);
-
-      // Under Linux, getline removes \n from the input stream. 
-      // However, it does not remove the \r
-      // Let's remove it
-      if (first_line.size() > 0 && first_line[first_line.size() - 1] == '\r') {
-        first_line.pop_back();
+    // Comment lines are recognized by their first byte and never tokenized
+    bool is_comment(std::string_view line) {
+      return current_dialect_.comment_character_ != '\0' && 
+        line.size() > 0 && line[0] == current_dialect_.comment_character_;
+    }
+
+    // Records the first error and wakes up the consumer. Safe to call 
+    // from either thread
+    void fail(std::exception_ptr error) {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (failed_)
+        return;
+      error_ = error;
+      failed_ = true;
+    }
+
+    // Called for a malformed row. Raises a ParseError unless the error 
+    // policy drops malformed rows, in which case the caller skips the row
+    void reject_row(std::string_view row, RowPosition position, size_t error_offset, const std::string& reason) {
+      const ErrorPolicy policy = current_dialect_.error_policy_;
+      if (policy == ErrorPolicy::strict || policy == ErrorPolicy::permissive) {
+        throw ParseError("error: " + reason + " in " + filename_ + " at byte " +
+          std::to_string(error_offset) + " (line " + std::to_string(position.line) + ")",
+          error_offset, position.line);
+      }
+      number_of_bad_rows_ += 1;
+      if (policy == ErrorPolicy::quarantine) {
+        if (quarantine_.is_open()) {
+          quarantine_ << position.offset << ',' << position.line << ',';
+          write_quoted(reason);
+          quarantine_ << ',';
+          write_quoted(row);
+          quarantine_ << '\n';
+        }
+        errors_.enqueue(RowError{ position.offset, position.line, reason, std::string(row) });
       }
+    }
 
-      split(first_line);
+    // Writes a field of the quarantine file in quotes, doubling the quote
+    // characters in it
+    void write_quoted(std::string_view field) {
+      const char quote_character = current_dialect_.quote_character_;
+      quarantine_ << quote_character;
+      for (char ch : field) {
+        if (ch == quote_character)
+          quarantine_ << ch;
+        quarantine_ << ch;
+      }
+      quarantine_ << quote_character;
+    }
+
+    // The header can't be dropped, so it is checked regardless of the
+    // error policy
+    void check_utf8(std::string_view row, RowPosition position) {
+      size_t invalid = validate_utf8(row.data(), row.size());
+      if (invalid != row.size()) {
+        throw ParseError("error: Invalid UTF-8 in " + filename_ + " at byte " +
+          std::to_string(position.offset + invalid) + " (line " + std::to_string(position.line) + ")",
+          position.offset + invalid, position.line);
+      }
+    }
+
+    // Runs on the reading thread. Errors are handed over to the consumer
+    // instead of taking down the process
+    void read_internal() {
+      try {
+        if (!current_dialect_.quarantine_file_.empty() &&
+          current_dialect_.error_policy_ == ErrorPolicy::quarantine) {
+          quarantine_.open(current_dialect_.quarantine_file_, std::ios::binary | std::ios::app);
+          if (!quarantine_.is_open())
+            throw std::runtime_error("error: Failed to open " + current_dialect_.quarantine_file_);
+        }
+        read_rows();
+      }
+      catch (...) {
+        // Let the consumer finish with the rows it already has
+        expected_number_of_rows_ = number_of_rows_read_;
+        fail(std::current_exception());
+      }
+      stream_.close();
+      if (quarantine_.is_open())
+        quarantine_.close();
+      reading_finished_ = true;
+    }
+
+    RecordBatch new_record_batch() {
+      RecordBatch batch;
+      if (free_batches_.try_dequeue(batch))
+        return batch;
+      for (size_t i : kept_columns_)
+        batch.add_column(headers_[i], column_types_[i], batch_rows_, dictionaries_[i]);
+      return batch;
+    }
+
+    void read_rows() {
+      RowFramer framer(open_input(), current_dialect_);
+      if (transcoder_)
+        framer.map_offsets(*transcoder_);
+      std::string_view row;
+
+      // Skip the preamble
+      for (size_t i = 0; i < current_dialect_.skip_lines_; ++i)
+        if (!framer.next(row))
+          break;
+
+      tokenizer_.configure(current_dialect_);
+
+      // Get first line and find headers by splitting on delimiters
+      std::string_view first_line;
+      bool has_first_line = false;
+      while ((has_first_line = framer.next(first_line)) && is_comment(first_line)) {}
+      if (!has_first_line)
+        first_line = std::string_view();
+      const bool validate_utf8 = current_dialect_.validate_utf8_;
+      if (validate_utf8 && current_dialect_.header_)
+        check_utf8(first_line, RowPosition{ framer.row_offset(), framer.row_line() });
+
+      tokenizer_.split(first_line);
+      const auto& fields = tokenizer_.fields();
       if (current_dialect_.header_) {
-        headers_ = current_split_result_;
+        headers_.assign(fields.begin(), fields.end());
       }
       else {
         headers_.clear();
@@ -274,213 +642,257 @@ namespace csv {
           headers_ = current_dialect_.column_names_;
         }
         else {
-          for (size_t i = 0; i < current_split_result_.size(); i++)
+          for (size_t i = 0; i < fields.size(); i++)
             headers_.push_back(std::to_string(i));
         }
-        // return to start before getline()
-        stream_.seekg(length, std::ios_base::beg);
       }
 
-      columns_ = headers_.size();
+      // Without a header, the first line is the first row. It is still 
+      // in the framer's buffer since next() hasn't been called since
+      bool first_line_is_row = has_first_line && !current_dialect_.header_;
 
-      for (auto& header : headers_)
-        current_row_[header] = "";
-      if (ignore_columns_enabled_)
-        for (auto&kvpair : current_dialect_.ignore_columns_)
-          current_row_.erase(kvpair.first);
+      columns_ = headers_.size();
+      tokenizer_.columns(headers_.size());
+
+      // Resolve the declared column types to column indices once
+      column_types_.assign(columns_, ColumnType{ Type::string, 0 });
+      for (size_t i = 0; i < columns_; ++i) {
+        auto it = current_dialect_.column_types_.find(headers_[i]);
+        if (it != current_dialect_.column_types_.end())
+          column_types_[i] = it->second;
+      }
 
-      // Start processing thread
-      processing_thread_ = std::thread(&Reader::process_values, this);
-      processing_thread_started_ = true;
+      // Rows carry converted values if any column is typed
+      typed_ = std::any_of(column_types_.begin(), column_types_.end(), [](ColumnType type) {
+        return type.type != Type::string && type.type != Type::dictionary;
+      });
+
+      // Columns that make it into maps and record batches
+      kept_columns_.clear();
+      for (size_t i = 0; i < columns_; ++i)
+        if (!ignore_columns_enabled_ || current_dialect_.ignore_columns_.count(headers_[i]) == 0)
+          kept_columns_.push_back(i);
+      // Dictionary columns keep their codes from one batch to the next
+      dictionaries_.assign(columns_, nullptr);
+      for (size_t i = 0; i < columns_; ++i)
+        if (column_types_[i].type == Type::dictionary)
+          dictionaries_[i] = std::make_shared<DictionaryBuilder>();
+      RecordBatch batch;
+      if (batch_rows_ > 0)
+        batch = new_record_batch();
+
+      std::atomic_store(&schema_, std::shared_ptr<const Schema>(
+        std::make_shared<Schema>(headers_, column_types_, current_dialect_.quote_character_,
+          lazy_rows_ ? std::make_shared<const Tokenizer>(tokenizer_) : nullptr)));
+      if (header_handler_)
+        header_handler_(headers_);
+      const std::shared_ptr<const Schema> schema = schema_;
 
       // Get lines one at a time, split on the delimiter and 
-      // enqueue the split results into the values_ queue
+      // enqueue the split results into the rows_ queue
       bool skip_empty_rows = current_dialect_.skip_empty_rows_;
-      std::string row;
-      size_t number_of_rows = 0;
-
-      while (std::getline(stream_, row)) {
+      bool check_field_count = current_dialect_.error_policy_ != ErrorPolicy::permissive;
+      bool nulls_enabled = tokenizer_.nulls_enabled();
+      // Lazy rows that nothing needs to look into are never split here
+      bool skip_split = lazy_rows_ && !filter_ && !check_field_count && !row_handler_ && batch_rows_ == 0;
+      size_t& number_of_rows = number_of_rows_read_;
+
+      while (first_line_is_row || framer.next(row)) {
+        if (first_line_is_row) {
+          row = first_line;
+          first_line_is_row = false;
+        }
         if (number_of_rows == expected_number_of_rows_)
           break;
-        if (row.size() > 0 && row[row.size() - 1] == '\r')
-          row.pop_back();
-        if (row != "" || (!skip_empty_rows && row == "")) {
-          split(row);
-          for (auto& value : current_split_result_)
-            values_.enqueue(values_ptoken_, value);
-          number_of_rows += 1;
+        if (is_comment(row))
+          continue;
+        // Comes straight from the framer, which already walked the row
+        const RowPosition position{ framer.row_offset(), framer.row_line() };
+        if (validate_utf8) {
+          size_t invalid = csv::validate_utf8(row.data(), row.size());
+          if (invalid != row.size()) {
+            reject_row(row, position, position.offset + invalid, "Invalid UTF-8");
+            continue;
+          }
         }
-      }
-
-      stream_.close();
-    }
-
-    void process_values() {
-      size_t index = 0;
-      auto ignore_columns = current_dialect_.ignore_columns_;
-      size_t i;
-      std::string_view column_name;
-      size_t number_of_rows = 0;
-      while (number_of_rows < expected_number_of_rows_) {
-        if (front(current_value_)) {
-          i = index % columns_;
-          column_name = headers_[i];
-          if (!ignore_columns_enabled_ || ignore_columns.count(column_name) == 0)
-            current_row_[column_name] = current_value_;
-          index += 1;
-          if (index != 0 && index % columns_ == 0) {
-            rows_.try_enqueue(current_row_);
+        if (row != "" || (!skip_empty_rows && row == "")) {
+          if (skip_split) {
+            rows_.enqueue(rows_ptoken_, make_lazy_row(schema, row, position));
             number_of_rows += 1;
-            number_of_rows_processed_.enqueue(number_of_rows);
+            continue;
           }
-        }
-      }
-    }
-
-    // trim white spaces from the left end of an input string
-    std::string ltrim(std::string const& input) {
-      std::string result = input;
-      result.erase(result.begin(), std::find_if(result.begin(), result.end(), [=](int ch) {
-        return !(std::find(current_dialect_.trim_characters_.begin(), current_dialect_.trim_characters_.end(), ch)
-          != current_dialect_.trim_characters_.end());
-      }));
-      return result;
-    }
-
-    // trim white spaces from right end of an input string
-    std::string rtrim(std::string const& input) {
-      std::string result = input;
-      result.erase(std::find_if(result.rbegin(), result.rend(), [=](int ch) {
-        return !(std::find(current_dialect_.trim_characters_.begin(), current_dialect_.trim_characters_.end(), ch)
-          != current_dialect_.trim_characters_.end());
-      }).base(), result.end());
-      return result;
-    }
-
-    // trim white spaces from either end of an input string
-    std::string trim(std::string const& input) {
-      if (current_dialect_.trim_characters_.size() == 0)
-        return input;
-      return ltrim(rtrim(input));
-    }
-
-    // split string based on a delimiter sub-string
-    void split(std::string const& input_string) {
-      current_split_result_.clear();
-      if (input_string == "") {
-        current_split_result_ = std::vector<std::string>(columns_, "");
-      }
-
-      std::string sub_result = "";
-      bool discard_delimiter = false;
-      size_t quotes_encountered = 0;
-      size_t input_string_size = input_string.size();
-
-      for (size_t i = 0; i < input_string_size; ++i) {
-
-        // Check if ch is the start of a delimiter sequence
-        bool delimiter_detected = false;
-        for (size_t j = 0; j < current_dialect_.delimiter_.size(); ++j) {
-
-          char ch = input_string[i];
-          if (ch != current_dialect_.delimiter_[j]) {
-            delimiter_detected = false;
-            break;
+          tokenizer_.split(row);
+          if (check_field_count && tokenizer_.field_count() != columns_) {
+            reject_row(row, position, position.offset, "Expected " +
+              std::to_string(columns_) + " fields but found " + std::to_string(tokenizer_.field_count()));
+            continue;
           }
-          else {
-            // ch *might* be the start of a delimiter sequence
-            if (j + 1 == current_dialect_.delimiter_.size()) {
-              if (quotes_encountered % 2 == 0) {
-                // Reached end of delimiter sequence without breaking
-                // delimiter detected!
-                delimiter_detected = true;
-                current_split_result_.push_back(trimming_enabled_ ? trim(sub_result) : sub_result);
-                sub_result = "";
-
-                // If enabled, skip initial space right after delimiter
-                if (i + 1 < input_string_size) {
-                  if (current_dialect_.skip_initial_space_ && input_string[i + 1] == ' ') {
-                    i = i + 1;
-                  }
-                }
-                quotes_encountered = 0;
-              }
-              else {
-                sub_result += input_string[i];
-                i = i + 1;
-                if (i == input_string_size) break;
-              }
+          if (filter_ && !filter_(fields))
+            continue;
+          if (row_handler_) {
+            std::string error;
+            if (!row_handler_(fields, nulls_enabled ? &tokenizer_.validity() : nullptr, position, error)) {
+              reject_row(row, position, position.offset, error);
+              continue;
             }
-            else {
-              // Keep looking
-              i = i + 1;
-              if (i == input_string_size) break;
+            number_of_rows += 1;
+            continue;
+          }
+          if (batch_rows_ > 0) {
+            batch.append(fields, kept_columns_, nulls_enabled ? &tokenizer_.validity() : nullptr,
+              current_dialect_.quote_character_, position);
+            if (batch.num_rows() == batch_rows_) {
+              batch.finish();
+              batches_.enqueue(std::move(batch));
+              batch = new_record_batch();
             }
+            number_of_rows += 1;
+            continue;
           }
+          if (lazy_rows_)
+            rows_.enqueue(rows_ptoken_, make_lazy_row(schema, row, position));
+          else
+            rows_.enqueue(rows_ptoken_, make_row(schema, fields, 
+              nulls_enabled ? &tokenizer_.validity() : nullptr, position));
+          number_of_rows += 1;
         }
+      }
 
-        // base case
-        if (!delimiter_detected)
-          sub_result += input_string[i];
-
-        if (input_string[i] == current_dialect_.quote_character_)
-          quotes_encountered += 1;
-        if (input_string[i] == current_dialect_.quote_character_ &&
-          current_dialect_.double_quote_ &&
-          sub_result.size() >= 2 &&
-          sub_result[sub_result.size() - 2] == input_string[i])
-          quotes_encountered -= 1;
+      if (batch.num_rows() > 0) {
+        batch.finish();
+        batches_.enqueue(std::move(batch));
       }
 
-      if (sub_result != "")
-        current_split_result_.push_back(trimming_enabled_ ? trim(sub_result) : sub_result);
+      // Let the consumer know how many rows are coming
+      expected_number_of_rows_ = number_of_rows;
+    }
 
-      if (current_split_result_.size() < columns_) {
-        for (size_t i = current_split_result_.size(); i < columns_; i++) {
-          current_split_result_.push_back("");
+    // Copies a row into the arena: the field views, then the converted 
+    // values if a column is typed, then the null bits, then the bytes of 
+    // the fields. It is a single allocation so that the whole row ends up
+    // in the same chunk
+    Row make_row(const std::shared_ptr<const Schema>& schema, 
+      const std::vector<std::string_view>& fields, const Bitmap* validity, RowPosition position) {
+      const size_t views_size = fields.size() * sizeof(std::string_view);
+      const size_t values_size = typed_ ? fields.size() * sizeof(ConvertedField) : 0;
+      const size_t validity_size = validity ? (fields.size() + 7) / 8 : 0;
+      size_t size = views_size + values_size + validity_size;
+      for (auto& field : fields)
+        size += field.size();
+      static_assert(alignof(ConvertedField) <= alignof(std::string_view), "converted values follow the views");
+      char* memory = static_cast<char*>(arena_.allocate(size, alignof(std::string_view)));
+
+      auto* views = reinterpret_cast<std::string_view*>(memory);
+      auto* values = reinterpret_cast<ConvertedField*>(memory + views_size);
+      if (typed_) {
+        const char quote_character = current_dialect_.quote_character_;
+        for (size_t i = 0; i < fields.size(); ++i) {
+          ConvertedField field;
+          field.type = Type::string;
+          field.integer = 0;
+          if (i < column_types_.size() && (!validity || validity->test(i)))
+            field = convert_field(fields[i], column_types_[i], quote_character);
+          new (values + i) ConvertedField(field);
         }
       }
-      else if (current_split_result_.size() > columns_ && columns_ != 0) {
-        current_split_result_.resize(columns_);
+      char* bytes = memory + views_size + values_size;
+      if (validity) {
+        std::memcpy(bytes, validity->data(), validity_size);
+        bytes += validity_size;
+      }
+      for (size_t i = 0; i < fields.size(); ++i) {
+        const size_t length = fields[i].size();
+        if (length > 0)
+          std::memcpy(bytes, fields[i].data(), length);
+        new (views + i) std::string_view(bytes, length);
+        bytes += length;
       }
+
+      Row row;
+      row.schema_ = schema;
+      row.chunk_ = arena_.chunk();
+      row.fields_ = views;
+      row.size_ = fields.size();
+      row.validity_ = validity ? reinterpret_cast<const uint8_t*>(memory + views_size + values_size) : nullptr;
+      row.values_ = typed_ ? values : nullptr;
+      row.position_ = position;
+      return row;
+    }
+
+    // Copies the raw line into the arena, to be split later
+    Row make_lazy_row(const std::shared_ptr<const Schema>& schema, std::string_view line, RowPosition position) {
+      char* bytes = static_cast<char*>(arena_.allocate(line.size(), 1));
+      if (line.size() > 0)
+        std::memcpy(bytes, line.data(), line.size());
+      Row row;
+      row.schema_ = schema;
+      row.chunk_ = arena_.chunk();
+      row.size_ = columns_;
+      row.position_ = position;
+      row.lazy_ = true;
+      row.raw_ = std::string_view(bytes, line.size());
+      return row;
     }
 
     std::string filename_;
     std::ifstream stream_;
+    std::unique_ptr<TranscodingBuffer> transcoder_;
+    std::unique_ptr<std::istream> transcoded_stream_;
     std::vector<std::string> headers_;
-    unordered_flat_map<std::string_view, std::string> current_row_;
-    std::string current_value_;
-    ConcurrentQueue<unordered_flat_map<std::string_view, std::string>> rows_;
+    ConcurrentQueue<Row> rows_;
+    Arena arena_;
     ProducerToken rows_ptoken_;
     ConsumerToken rows_ctoken_;
-    ConcurrentQueue<size_t> number_of_rows_processed_;
+    std::vector<ColumnType> column_types_;
+    bool typed_;
+    std::shared_ptr<const Schema> schema_;
+    bool lazy_rows_;
 
-    // Member variables to keep track of rows/cols
-    size_t columns_;
-    size_t expected_number_of_rows_;
+    // The row taken off the queue by ready()
+    Row pending_row_;
+    bool has_pending_row_;
 
-    // Member variables to enable streaming
-    ConcurrentQueue<size_t> row_iterator_queue_;
-    size_t row_iterator_index_;
+    // Member variables to keep track of rows/cols
+    // columns_ is set by the reading thread once it has the header.
+    // counted_rows_ caches count_rows() for shape() and is only used on 
+    // the thread that calls read() and shape()
+    static constexpr size_t unknown_number_of_rows = static_cast<size_t>(-1);
+    std::atomic<size_t> columns_;
+    std::atomic<size_t> expected_number_of_rows_;
+    size_t counted_rows_;
 
     std::thread reading_thread_;
     bool reading_thread_started_;
 
-    std::thread processing_thread_;
-    std::atomic<bool> processing_thread_started_;
-
-    ConcurrentQueue<std::string> values_;
-    ProducerToken values_ptoken_;
-    ConsumerToken values_ctoken_;
     std::string current_dialect_name_;
     unordered_flat_map<std::string, Dialect> dialects_;
     Dialect current_dialect_;
-    size_t done_index_;
-    size_t ready_index_;
-    size_t next_index_;
     bool ignore_columns_enabled_;
-    bool trimming_enabled_;
-    std::vector<std::string> current_split_result_;
+    Tokenizer tokenizer_;
+
+    // Rows handed over to the consumer so far, and the error
+    // that stopped the reading thread, if any
+    size_t number_of_rows_read_;
+    std::exception_ptr error_;
+    std::atomic<bool> failed_;
+    std::mutex error_mutex_;
+
+    // Malformed rows dropped by the error policy
+    std::atomic<size_t> number_of_bad_rows_;
+    ConcurrentQueue<RowError> errors_;
+    std::ofstream quarantine_;
+
+    // Record batches, see record_batches()
+    size_t batch_rows_;
+    std::vector<size_t> kept_columns_;
+    std::vector<std::shared_ptr<DictionaryBuilder>> dictionaries_;
+    ConcurrentQueue<RecordBatch> batches_;
+    ConsumerToken batches_ctoken_;
+    ConcurrentQueue<RecordBatch> free_batches_;
+    std::atomic<bool> reading_finished_;
+    std::function<bool(const std::vector<std::string_view>&)> filter_;
+    std::function<void(const std::vector<std::string>&)> header_handler_;
+    RowHandler row_handler_;
   };
 
 }
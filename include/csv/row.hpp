@@ -0,0 +1,268 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/arena.hpp>
+#include <csv/robin_hood.hpp>
+#include <csv/types.hpp>
+#include <csv/framer.hpp>
+#include <csv/tokenizer.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  // A column resolved once with Schema::handle() and used with Row::get()
+  // instead of looking the column up by name on every row
+  struct ColumnHandle {
+    size_t index;
+  };
+
+  // The columns of a file: names, declared types and a name -> index
+  // lookup. One schema is shared by all the rows of a file
+  class Schema {
+  public:
+    Schema(const std::vector<std::string>& names, const std::vector<ColumnType>& types, char quote_character,
+      std::shared_ptr<const Tokenizer> tokenizer = nullptr) :
+      names_(names),
+      types_(types),
+      quote_character_(quote_character),
+      tokenizer_(std::move(tokenizer)) {
+      for (size_t i = 0; i < names_.size(); ++i)
+        indices_.emplace(names_[i], i);
+    }
+
+    size_t size() const {
+      return names_.size();
+    }
+
+    const std::vector<std::string>& names() const {
+      return names_;
+    }
+
+    const std::string& name(size_t index) const {
+      return names_[index];
+    }
+
+    ColumnType type(size_t index) const {
+      return types_[index];
+    }
+
+    char quote_character() const {
+      return quote_character_;
+    }
+
+    bool contains(const std::string& name) const {
+      return indices_.find(name) != indices_.end();
+    }
+
+    ColumnHandle handle(const std::string& name) const {
+      auto it = indices_.find(name);
+      if (it == indices_.end())
+        throw std::runtime_error("error: Column " + name + " not found");
+      return ColumnHandle{ it->second };
+    }
+
+    // Splits lazy rows, see Reader::lazy_rows()
+    const Tokenizer* tokenizer() const {
+      return tokenizer_.get();
+    }
+
+  private:
+    std::vector<std::string> names_;
+    std::vector<ColumnType> types_;
+    char quote_character_;
+    std::shared_ptr<const Tokenizer> tokenizer_;
+    unordered_flat_map<std::string, size_t> indices_;
+  };
+
+  // A row as a list of fields, indexed like the schema's columns
+  // The fields, their views, the null bits and the converted values of
+  // typed columns all live in an arena chunk shared with neighbouring
+  // rows. Copying a row only bumps the chunk's reference count, and the
+  // views stay valid as long as a copy is alive.
+  // Lazy rows only hold the raw line and split it on first access, as far
+  // as the column asked for, and convert typed fields as they are read.
+  // Each copy of a lazy row splits on its own
+  class Row {
+  public:
+    Row() :
+      fields_(nullptr),
+      size_(0),
+      validity_(nullptr),
+      values_(nullptr),
+      position_{ 0, 0 },
+      lazy_(false) {}
+
+    Row(const Row& other) :
+      schema_(other.schema_),
+      chunk_(other.chunk_),
+      fields_(other.fields_),
+      size_(other.size_),
+      validity_(other.validity_),
+      values_(other.values_),
+      position_(other.position_),
+      lazy_(other.lazy_),
+      raw_(other.raw_) {}
+
+    Row(Row&&) = default;
+
+    Row& operator=(const Row& other) {
+      if (this != &other) {
+        schema_ = other.schema_;
+        chunk_ = other.chunk_;
+        fields_ = other.fields_;
+        size_ = other.size_;
+        validity_ = other.validity_;
+        values_ = other.values_;
+        position_ = other.position_;
+        lazy_ = other.lazy_;
+        raw_ = other.raw_;
+        split_.reset();
+      }
+      return *this;
+    }
+
+    Row& operator=(Row&&) = default;
+
+    size_t size() const {
+      return size_;
+    }
+
+    std::string_view operator[](size_t index) const {
+      if (!lazy_)
+        return fields_[index];
+      const Split& split = split_to(index);
+      return index < split.fields.size() ? split.fields[index] : std::string_view();
+    }
+
+    std::string_view get(ColumnHandle column) const {
+      return (*this)[column.index];
+    }
+
+    // Looks the column up by name; prefer get(ColumnHandle) in loops
+    std::string_view get(const std::string& column) const {
+      return (*this)[schema_->handle(column).index];
+    }
+
+    // Whether a field matched one of the dialect's null tokens
+    bool is_null(size_t index) const {
+      if (!lazy_)
+        return validity_ != nullptr && ((validity_[index / 8] >> (index % 8)) & 1) == 0;
+      const Split& split = split_to(index);
+      return split.validity.size() > 0 && !split.validity.test(index);
+    }
+
+    // The field converted to the type declared for its column. Fields of
+    // typed columns were converted on the reading thread, except in lazy rows
+    Value value(size_t index) const {
+      if (values_ == nullptr)
+        return parse_value((*this)[index], schema_->type(index), schema_->quote_character());
+      return to_value(values_[index], schema_->type(index), fields_[index]);
+    }
+
+    // The line as it is in the file, without the line terminator, for lazy
+    // rows. Empty for other rows
+    std::string_view raw() const {
+      return raw_;
+    }
+
+    bool lazy() const {
+      return lazy_;
+    }
+
+    // Number of fields split so far. Always size() for rows that aren't lazy
+    size_t fields_split() const {
+      if (!lazy_)
+        return size_;
+      return split_ ? split_->fields.size() : 0;
+    }
+
+    const Schema& schema() const {
+      return *schema_;
+    }
+
+    // Where the row starts in the file
+    RowPosition position() const {
+      return position_;
+    }
+
+  private:
+    friend class Reader;
+
+    // The fields of a lazy row split so far
+    struct Split {
+      std::vector<std::string_view> fields;
+      std::unique_ptr<char[]> unescaped;
+      size_t unescaped_size = 0;
+      Bitmap validity;
+      size_t next = 0;              // where the next field starts, npos at the end
+    };
+
+    const Split& split_to(size_t index) const {
+      const Tokenizer& tokenizer = *schema_->tokenizer();
+      if (!split_) {
+        split_ = std::make_unique<Split>();
+        if (tokenizer.dialect().escape_character_ != '\0')
+          split_->unescaped.reset(new char[raw_.size()]);
+        if (tokenizer.nulls_enabled())
+          split_->validity.resize(size_);
+      }
+      Split& split = *split_;
+      if (index >= split.fields.size() && split.next != std::string::npos) {
+        split.next = tokenizer.split_fields(raw_, split.next, index + 1, split.fields,
+          split.unescaped.get(), split.unescaped_size, split.validity.size() > 0 ? &split.validity : nullptr);
+        // Short row: the missing fields are empty
+        if (split.fields.size() <= index) {
+          split.next = std::string::npos;
+          if (split.validity.size() > 0)
+            tokenizer.mark_missing_fields_null(split.validity, split.fields.size());
+        }
+      }
+      return split;
+    }
+
+    std::shared_ptr<const Schema> schema_;
+    std::shared_ptr<const ArenaChunk> chunk_;
+    const std::string_view* fields_;
+    size_t size_;
+    const uint8_t* validity_;       // null when the dialect has no null tokens
+    const ConvertedField* values_;  // null when no column is typed
+    RowPosition position_;
+    bool lazy_;
+    std::string_view raw_;
+    mutable std::unique_ptr<Split> split_;
+  };
+
+}
@@ -0,0 +1,130 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CSV_SCANNER_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace csv {
+
+  // Index of the lowest set bit in a non-zero mask
+  inline unsigned count_trailing_zeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+  }
+
+  // Number of set bits in a mask
+  inline unsigned popcount(uint32_t mask) {
+#if defined(_MSC_VER)
+    mask = mask - ((mask >> 1) & 0x55555555);
+    mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+    return static_cast<unsigned>((((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+#else
+    return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+  }
+
+  // Finds the next byte that belongs to a small set of special characters,
+  // e.g., the first byte of the delimiter, the quote character and the 
+  // escape character. With SSE2, 16 bytes are compared against all of 
+  // the special characters at once; otherwise a lookup table is used
+  class Scanner {
+  public:
+    static constexpr size_t max_characters = 8;
+
+    Scanner() : count_(0) {
+      for (auto& entry : table_)
+        entry = false;
+    }
+
+    explicit Scanner(std::initializer_list<char> characters) : Scanner() {
+      for (char ch : characters)
+        add(ch);
+    }
+
+    // Characters beyond max_characters are ignored
+    void add(char ch) {
+      if (table_[static_cast<unsigned char>(ch)] || count_ == max_characters)
+        return;
+      table_[static_cast<unsigned char>(ch)] = true;
+      characters_[count_++] = ch;
+    }
+
+    bool is_special(char ch) const {
+      return table_[static_cast<unsigned char>(ch)];
+    }
+
+    // Position of the first special character in data[from, size), 
+    // or size if there is none
+    size_t find(const char* data, size_t size, size_t from) const {
+      size_t i = from;
+#if defined(CSV_SCANNER_SSE2)
+      if (count_ > 0) {
+        __m128i needles[max_characters];
+        for (size_t j = 0; j < count_; ++j)
+          needles[j] = _mm_set1_epi8(characters_[j]);
+        for (; i + 16 <= size; i += 16) {
+          __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+          __m128i matches = _mm_cmpeq_epi8(block, needles[0]);
+          for (size_t j = 1; j < count_; ++j)
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, needles[j]));
+          uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+          if (mask != 0)
+            return i + count_trailing_zeros(mask);
+        }
+      }
+#endif
+      for (; i < size; ++i)
+        if (table_[static_cast<unsigned char>(data[i])])
+          return i;
+      return size;
+    }
+
+  private:
+    bool table_[256];
+    char characters_[max_characters];
+    size_t count_;
+  };
+
+}
@@ -0,0 +1,314 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/dialect.hpp>
+#include <csv/robin_hood.hpp>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+
+namespace csv {
+
+  // Deduces the format of a CSV file from a small sample, 
+  // in the spirit of Python's csv.Sniffer
+  class Sniffer {
+  public:
+    Sniffer() :
+      delimiters_(",;\t|"),
+      quote_characters_("\"'") {}
+
+    // Restrict the set of candidate delimiters, e.g., ",;"
+    Sniffer& delimiters(const std::string& delimiters) {
+      delimiters_ = delimiters;
+      return *this;
+    }
+
+    // Restrict the set of candidate quote characters
+    Sniffer& quote_characters(const std::string& quote_characters) {
+      quote_characters_ = quote_characters;
+      return *this;
+    }
+
+    Dialect sniff(std::string_view sample) {
+      Dialect dialect;
+      sample = strip_bom(sample);
+      auto lines = split_lines(sample);
+      char quote_character = guess_quote_character(lines);
+      char delimiter = guess_delimiter(lines, quote_character);
+      dialect
+        .line_terminator(guess_line_terminator(sample))
+        .quote_character(quote_character)
+        .delimiter(std::string(1, delimiter))
+        .skip_initial_space(guess_skip_initial_space(lines, delimiter, quote_character))
+        .header(guess_header(lines, delimiter, quote_character));
+      return dialect;
+    }
+
+    bool has_header(std::string_view sample) {
+      return sniff(sample).header_;
+    }
+
+  private:
+    std::string_view strip_bom(std::string_view sample) {
+      if (sample.size() >= 3 && sample.substr(0, 3) == "\xEF\xBB\xBF")
+        sample.remove_prefix(3);
+      return sample;
+    }
+
+    std::string guess_line_terminator(std::string_view sample) {
+      size_t position = sample.find_first_of("\r\n");
+      if (position == std::string_view::npos || sample[position] == '\n')
+        return "\n";
+      if (position + 1 < sample.size() && sample[position + 1] == '\n')
+        return "\r\n";
+      return "\r";
+    }
+
+    std::vector<std::string_view> split_lines(std::string_view sample) {
+      std::vector<std::string_view> lines;
+      size_t start = 0;
+      while (start < sample.size()) {
+        size_t end = sample.find_first_of("\r\n", start);
+        if (end == std::string_view::npos)
+          end = sample.size();
+        if (end > start)
+          lines.push_back(sample.substr(start, end - start));
+        start = end + 1;
+      }
+      return lines;
+    }
+
+    bool is_candidate_delimiter(char ch) {
+      return delimiters_.find(ch) != std::string::npos;
+    }
+
+    // A quote character opens a field at the start of a line or right after 
+    // a delimiter (optionally followed by a space), and closes one right before
+    // a delimiter or the end of a line
+    char guess_quote_character(const std::vector<std::string_view>& lines) {
+      char result = '"';
+      size_t best_score = 0;
+      for (char quote_character : quote_characters_) {
+        size_t score = 0;
+        for (auto& line : lines) {
+          for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] != quote_character)
+              continue;
+            bool opens = (i == 0 || is_candidate_delimiter(line[i - 1]) ||
+              (line[i - 1] == ' ' && i >= 2 && is_candidate_delimiter(line[i - 2])));
+            bool closes = (i + 1 == line.size() || is_candidate_delimiter(line[i + 1]));
+            if (opens || closes)
+              score += 1;
+          }
+        }
+        if (score > best_score) {
+          best_score = score;
+          result = quote_character;
+        }
+      }
+      return result;
+    }
+
+    size_t count_unquoted(std::string_view line, char delimiter, char quote_character) {
+      size_t count = 0;
+      bool quoted = false;
+      for (char ch : line) {
+        if (ch == quote_character)
+          quoted = !quoted;
+        else if (ch == delimiter && !quoted)
+          count += 1;
+      }
+      return count;
+    }
+
+    // Pick the delimiter that occurs the same number of times on most lines.
+    // Ties go to the candidate listed first
+    char guess_delimiter(const std::vector<std::string_view>& lines, char quote_character) {
+      char result = delimiters_.empty() ? ',' : delimiters_[0];
+      size_t best_consistency = 0;
+      for (char delimiter : delimiters_) {
+        unordered_flat_map<size_t, size_t> frequencies;
+        for (auto& line : lines)
+          frequencies[count_unquoted(line, delimiter, quote_character)] += 1;
+        size_t mode = 0, consistency = 0;
+        for (auto& kvpair : frequencies) {
+          if (kvpair.second > consistency || (kvpair.second == consistency && kvpair.first > mode)) {
+            mode = kvpair.first;
+            consistency = kvpair.second;
+          }
+        }
+        if (mode > 0 && consistency > best_consistency) {
+          best_consistency = consistency;
+          result = delimiter;
+        }
+      }
+      return result;
+    }
+
+    bool guess_skip_initial_space(const std::vector<std::string_view>& lines, char delimiter, char quote_character) {
+      size_t delimiters = 0, spaces = 0;
+      for (auto& line : lines) {
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+          if (line[i] == quote_character)
+            quoted = !quoted;
+          else if (line[i] == delimiter && !quoted) {
+            delimiters += 1;
+            if (i + 1 < line.size() && line[i + 1] == ' ')
+              spaces += 1;
+          }
+        }
+      }
+      return delimiters > 0 && spaces == delimiters;
+    }
+
+    std::vector<std::string_view> split_line(std::string_view line, char delimiter, char quote_character) {
+      std::vector<std::string_view> result;
+      bool quoted = false;
+      size_t start = 0;
+      for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == quote_character)
+          quoted = !quoted;
+        else if (line[i] == delimiter && !quoted) {
+          result.push_back(line.substr(start, i - start));
+          start = i + 1;
+        }
+      }
+      result.push_back(line.substr(start));
+      return result;
+    }
+
+    bool is_number(std::string_view value, char quote_character) {
+      while (!value.empty() && (value.front() == ' ' || value.front() == quote_character))
+        value.remove_prefix(1);
+      while (!value.empty() && (value.back() == ' ' || value.back() == quote_character))
+        value.remove_suffix(1);
+      size_t i = 0;
+      if (i < value.size() && (value[i] == '-' || value[i] == '+'))
+        i += 1;
+      size_t digits = 0;
+      while (i < value.size() && value[i] >= '0' && value[i] <= '9') { i += 1; digits += 1; }
+      if (i < value.size() && value[i] == '.') {
+        i += 1;
+        while (i < value.size() && value[i] >= '0' && value[i] <= '9') { i += 1; digits += 1; }
+      }
+      if (digits > 0 && i < value.size() && (value[i] == 'e' || value[i] == 'E')) {
+        i += 1;
+        if (i < value.size() && (value[i] == '-' || value[i] == '+'))
+          i += 1;
+        size_t exponent_digits = 0;
+        while (i < value.size() && value[i] >= '0' && value[i] <= '9') { i += 1; exponent_digits += 1; }
+        if (exponent_digits == 0)
+          return false;
+      }
+      return digits > 0 && i == value.size();
+    }
+
+    // Same heuristic as Python's csv.Sniffer.has_header: the first row is a 
+    // header if its values don't look like the values in the rest of the column. 
+    // Columns are either numeric or, failing that, of a fixed length
+    bool guess_header(const std::vector<std::string_view>& lines, char delimiter, char quote_character) {
+      if (lines.size() < 2)
+        return true;
+
+      auto header = split_line(lines[0], delimiter, quote_character);
+      std::vector<bool> numeric(header.size(), true);
+      std::vector<size_t> lengths(header.size(), std::string::npos);
+      std::vector<bool> fixed_length(header.size(), true);
+      size_t data_rows = 0;
+
+      for (size_t i = 1; i < lines.size(); ++i) {
+        auto values = split_line(lines[i], delimiter, quote_character);
+        if (values.size() != header.size())
+          continue;
+        data_rows += 1;
+        for (size_t j = 0; j < values.size(); ++j) {
+          if (numeric[j] && !is_number(values[j], quote_character))
+            numeric[j] = false;
+          if (lengths[j] == std::string::npos)
+            lengths[j] = values[j].size();
+          else if (lengths[j] != values[j].size())
+            fixed_length[j] = false;
+        }
+      }
+
+      if (data_rows == 0)
+        return true;
+
+      int votes = 0;
+      for (size_t j = 0; j < header.size(); ++j) {
+        if (numeric[j])
+          votes += is_number(header[j], quote_character) ? -1 : 1;
+        else if (fixed_length[j])
+          votes += (header[j].size() != lengths[j]) ? 1 : -1;
+      }
+      return votes > 0;
+    }
+
+    std::string delimiters_;
+    std::string quote_characters_;
+  };
+
+  // Read at most sample_bytes from the current position of stream
+  // truncated tells whether there is more to read after the sample
+  inline std::string read_sample(std::istream& stream, size_t sample_bytes, bool& truncated) {
+    std::string sample(sample_bytes, '\0');
+    stream.read(&sample[0], static_cast<std::streamsize>(sample_bytes));
+    sample.resize(static_cast<size_t>(stream.gcount()));
+    truncated = sample.size() == sample_bytes && stream.peek() != std::istream::traits_type::eof();
+    return sample;
+  }
+
+  // Read at most sample_bytes from the start of filename and 
+  // deduce its dialect from them
+  inline Dialect sniff(const std::string& filename, size_t sample_bytes = 4096) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) {
+      throw std::runtime_error("error: Failed to open " + filename);
+    }
+
+    bool truncated;
+    std::string sample = read_sample(stream, sample_bytes, truncated);
+
+    // Don't let a line cut in half by the sample size skew the statistics
+    if (truncated) {
+      size_t last_line_end = sample.find_last_of("\r\n");
+      if (last_line_end != std::string::npos)
+        sample.resize(last_line_end + 1);
+    }
+
+    return Sniffer().sniff(sample);
+  }
+
+}
@@ -0,0 +1,317 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/dialect.hpp>
+#include <csv/scanner.hpp>
+#include <csv/types.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csv {
+
+  // Splits rows into fields according to a dialect. The fields are views
+  // into the row, or into an internal buffer for fields with escape 
+  // sequences, and stay valid until the next call to split()
+  class Tokenizer {
+  public:
+    Tokenizer() :
+      columns_(0),
+      trimming_enabled_(false),
+      nulls_enabled_(false),
+      null_lengths_(0),
+      field_count_(0) {}
+
+    explicit Tokenizer(const Dialect& dialect) : Tokenizer() {
+      configure(dialect);
+    }
+
+    void configure(const Dialect& dialect) {
+      dialect_ = dialect;
+      trimming_enabled_ = dialect_.trim_characters_.size() > 0;
+
+      // Characters that the tokenizer needs to stop at
+      scanner_ = Scanner();
+      if (dialect_.delimiter_.size() > 0)
+        scanner_.add(dialect_.delimiter_[0]);
+      scanner_.add(dialect_.quote_character_);
+      if (dialect_.escape_character_ != '\0')
+        scanner_.add(dialect_.escape_character_);
+
+      // Null tokens are matched while splitting. Their lengths are kept as
+      // a bit mask so most fields are rejected without a comparison
+      nulls_enabled_ = dialect_.null_values_.size() > 0;
+      null_lengths_ = 0;
+      for (auto& token : dialect_.null_values_)
+        null_lengths_ |= uint64_t(1) << std::min<size_t>(token.size(), 63);
+    }
+
+    // Rows are padded or truncated to columns fields. With 0, e.g., for 
+    // the header, rows keep the fields they have and nulls aren't tracked
+    void columns(size_t columns) {
+      columns_ = columns;
+      validity_.resize(columns_);
+    }
+
+    size_t columns() const {
+      return columns_;
+    }
+
+    const Dialect& dialect() const {
+      return dialect_;
+    }
+
+    const std::vector<std::string_view>& fields() const {
+      return fields_;
+    }
+
+    // Null fields of the last row, when the dialect declares null tokens
+    const Bitmap& validity() const {
+      return validity_;
+    }
+
+    bool nulls_enabled() const {
+      return nulls_enabled_;
+    }
+
+    // Number of fields in the last row before it was padded or truncated
+    size_t field_count() const {
+      return field_count_;
+    }
+
+    // split string based on a delimiter sub-string
+    // The results are views into input_string, or into unescaped_buffer_
+    // for fields that contain escape sequences; nothing is allocated here
+    void split(std::string_view input_string) {
+      fields_.clear();
+      field_count_ = columns_;
+      if (nulls_enabled_)
+        validity_.fill(true);
+      if (input_string.empty()) {
+        fields_.resize(columns_);
+        mark_missing_fields_null(validity_, 0);
+        return;
+      }
+
+      // Unescaped fields are never longer than the input, so the buffer
+      // is sized once per row and views into it stay valid
+      if (dialect_.escape_character_ != '\0' && unescaped_buffer_.size() < input_string.size())
+        unescaped_buffer_.resize(input_string.size());
+      size_t unescaped_size = 0;
+      const size_t end = split_fields(input_string, 0, std::string::npos, fields_, 
+        &unescaped_buffer_[0], unescaped_size, nulls_enabled_ ? &validity_ : nullptr);
+
+      // A trailing delimiter ends an empty field. It isn't kept, but it
+      // counts when checking the number of fields
+      field_count_ = fields_.size() + (end == input_string.size() ? 1 : 0);
+
+      if (fields_.size() < columns_) {
+        size_t fields = fields_.size();
+        fields_.resize(columns_);
+        mark_missing_fields_null(validity_, fields);
+      }
+      else if (fields_.size() > columns_ && columns_ != 0) {
+        fields_.resize(columns_);
+      }
+    }
+
+    // Split fields off input_string, starting with the field at offset, 
+    // until fields holds max_fields fields. Returns where the next field
+    // starts, so that splitting can resume there, or npos at the end of
+    // the input. Unescaped fields are written to unescaped, which must have
+    // room for input_string, starting at unescaped_size. Rows aren't padded
+    // or truncated here, see split()
+    size_t split_fields(std::string_view input_string, size_t offset, size_t max_fields,
+      std::vector<std::string_view>& fields, char* unescaped, size_t& unescaped_size, Bitmap* validity) const {
+      const std::string& delimiter = dialect_.delimiter_;
+      const size_t delimiter_size = delimiter.size();
+      const char quote_character = dialect_.quote_character_;
+      const char escape_character = dialect_.escape_character_;
+      const bool double_quote = dialect_.double_quote_;
+      const bool skip_initial_space = dialect_.skip_initial_space_;
+      const size_t input_string_size = input_string.size();
+      const char* data = input_string.data();
+
+      size_t field_start = offset;
+      size_t quotes_encountered = 0;
+      bool field_escaped = false;
+
+      auto push_field = [&](size_t field_end) {
+        auto value = input_string.substr(field_start, field_end - field_start);
+        // Null tokens are matched against the raw text, so "\\N" is
+        // recognized before it is unescaped
+        if (validity && fields.size() < columns_ &&
+          is_null(trimming_enabled_ ? trim(value) : value))
+          validity->set(fields.size(), false);
+        if (field_escaped) {
+          value = unescape(value, unescaped + unescaped_size);
+          unescaped_size += value.size();
+        }
+        fields.push_back(trimming_enabled_ ? trim(value) : value);
+      };
+
+      if (fields.size() >= max_fields)
+        return field_start;
+
+      size_t i = scanner_.find(data, input_string_size, field_start);
+      while (i < input_string_size) {
+        char ch = data[i];
+
+        if (ch == escape_character && escape_character != '\0') {
+          // The next character is part of the value, whatever it is
+          field_escaped = true;
+          i = scanner_.find(data, input_string_size, i + 2);
+          continue;
+        }
+
+        if (ch == quote_character) {
+          // With double_quote enabled, a run of consecutive quote
+          // characters only counts once
+          if (!(double_quote && i > field_start && data[i - 1] == quote_character))
+            quotes_encountered += 1;
+          i = scanner_.find(data, input_string_size, i + 1);
+          continue;
+        }
+
+        // Delimiters inside quotes are part of the value
+        if (delimiter_size > 0 && quotes_encountered % 2 == 0 &&
+          ch == delimiter[0] && input_string.compare(i, delimiter_size, delimiter) == 0) {
+          push_field(i);
+          i += delimiter_size;
+
+          // If enabled, skip initial space right after delimiter
+          if (skip_initial_space && i < input_string_size && data[i] == ' ')
+            i += 1;
+
+          field_start = i;
+          quotes_encountered = 0;
+          field_escaped = false;
+          if (fields.size() >= max_fields)
+            return field_start;
+          i = scanner_.find(data, input_string_size, i);
+          continue;
+        }
+
+        i = scanner_.find(data, input_string_size, i + 1);
+      }
+
+      if (field_start < input_string_size) {
+        push_field(input_string_size);
+        return std::string::npos;
+      }
+      return field_start;
+    }
+
+    // Fields missing from a short row are empty, so they are null 
+    // whenever the empty string is a null token
+    void mark_missing_fields_null(Bitmap& validity, size_t first) const {
+      if (nulls_enabled_ && is_null(std::string_view()))
+        for (size_t i = first; i < columns_; ++i)
+          validity.set(i, false);
+    }
+
+  private:
+    // Check a field against the dialect's null tokens
+    bool is_null(std::string_view value) const {
+      if (((null_lengths_ >> std::min<size_t>(value.size(), 63)) & 1) == 0)
+        return false;
+      for (auto& token : dialect_.null_values_)
+        if (value == token)
+          return true;
+      return false;
+    }
+
+    // trim white spaces from the left end of an input string
+    std::string_view ltrim(std::string_view input) const {
+      std::string_view trim_characters(dialect_.trim_characters_.data(),
+        dialect_.trim_characters_.size());
+      size_t start = input.find_first_not_of(trim_characters);
+      return (start == std::string_view::npos) ? std::string_view() : input.substr(start);
+    }
+
+    // trim white spaces from right end of an input string
+    std::string_view rtrim(std::string_view input) const {
+      std::string_view trim_characters(dialect_.trim_characters_.data(),
+        dialect_.trim_characters_.size());
+      size_t end = input.find_last_not_of(trim_characters);
+      return (end == std::string_view::npos) ? std::string_view() : input.substr(0, end + 1);
+    }
+
+    // trim white spaces from either end of an input string
+    std::string_view trim(std::string_view input) const {
+      if (dialect_.trim_characters_.size() == 0)
+        return input;
+      return ltrim(rtrim(input));
+    }
+
+    // Copy input_string to output, resolving escape sequences, and return
+    // a view of the copy
+    std::string_view unescape(std::string_view input_string, char* output) const {
+      const char escape_character = dialect_.escape_character_;
+      size_t size = 0;
+      for (size_t i = 0; i < input_string.size(); ++i) {
+        char ch = input_string[i];
+        if (ch == escape_character && i + 1 < input_string.size()) {
+          ch = input_string[++i];
+          switch (ch) {
+          case 'n': ch = '\n'; break;
+          case 'r': ch = '\r'; break;
+          case 't': ch = '\t'; break;
+          case 'b': ch = '\b'; break;
+          case 'f': ch = '\f'; break;
+          case 'v': ch = '\v'; break;
+          case '0': ch = '\0'; break;
+          default: break;
+          }
+        }
+        output[size++] = ch;
+      }
+      return std::string_view(output, size);
+    }
+
+    Dialect dialect_;
+    size_t columns_;
+    bool trimming_enabled_;
+    Scanner scanner_;
+    std::vector<std::string_view> fields_;
+    std::string unescaped_buffer_;
+
+    // Validity of the fields in fields_, when the dialect declares null tokens
+    bool nulls_enabled_;
+    uint64_t null_lengths_;
+    Bitmap validity_;
+    size_t field_count_;
+  };
+
+}
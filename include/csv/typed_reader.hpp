@@ -0,0 +1,277 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <csv/reader.hpp>
+#include <csv/concurrent_queue.hpp>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace csv {
+
+  namespace detail {
+
+    // Convert the field of one column of a typed reader. std::optional
+    // columns are empty for null fields; other columns can't be null
+    template <typename T>
+    bool convert_column(std::string_view field, bool valid, char quote_character,
+      const std::string& column, T& value, std::string& error) {
+      if constexpr (is_optional<T>::value) {
+        if (!valid) {
+          value.reset();
+          return true;
+        }
+        value.emplace();
+        if (from_field(field, quote_character, *value))
+          return true;
+      }
+      else {
+        if (!valid) {
+          error = "Null value in column " + column;
+          return false;
+        }
+        if (from_field(field, quote_character, value))
+          return true;
+      }
+      error = "Invalid value in column " + column;
+      return false;
+    }
+
+    // What TypedReader and StructReader have in common: N named columns,
+    // matched against the header once, and rows of RowType built on the 
+    // reading thread by a Converter and queued for the consumer. Everything
+    // the reading thread touches lives here, so it's all still around when
+    // the destructor of reader_ joins the thread
+    template <typename RowType, typename Converter, size_t N>
+    class ConvertingReader {
+    public:
+      Dialect& configure_dialect(const std::string& dialect_name = "excel") {
+        return reader_.configure_dialect(dialect_name);
+      }
+
+      void use_dialect(const std::string& dialect_name) {
+        reader_.use_dialect(dialect_name);
+      }
+
+      void read(const std::string& filename) {
+        reader_.handle_rows(
+          [this](const std::vector<std::string>& headers) { resolve_columns(headers); },
+          [this](const std::vector<std::string_view>& fields, const Bitmap* validity, RowPosition, std::string& error) {
+            RowType row{};
+            if (!converter_(*this, fields, validity, row, error))
+              return false;
+            rows_.enqueue(rows_ptoken_, std::move(row));
+            return true;
+          });
+        reader_.read(filename);
+      }
+
+      // Blocks until a row is available. Returns false once all rows have
+      // been handed out, and rethrows reading errors, e.g., a missing column
+      bool next(RowType& row) {
+        while (true) {
+          if (rows_.try_dequeue(rows_ctoken_, row))
+            return true;
+          if (reader_.finished()) {
+            // The last row might have been queued right before the flag
+            if (rows_.try_dequeue(rows_ctoken_, row))
+              return true;
+            reader_.rethrow_if_failed();
+            return false;
+          }
+          std::this_thread::yield();
+        }
+      }
+
+      std::vector<RowType> rows() {
+        std::vector<RowType> result;
+        RowType row{};
+        while (next(row))
+          result.push_back(std::move(row));
+        return result;
+      }
+
+      // Index of each column in the file, once the header has been read
+      const std::array<size_t, N>& indices() const {
+        return indices_;
+      }
+
+      bool next_error(RowError& error) {
+        return reader_.next_error(error);
+      }
+
+      size_t bad_rows() const {
+        return reader_.bad_rows();
+      }
+
+      // Converts column i of a row into value
+      template <typename T>
+      bool convert_field(const std::vector<std::string_view>& fields, const Bitmap* validity,
+        size_t i, T& value, std::string& error) const {
+        const size_t index = indices_[i];
+        return convert_column(fields[index], validity == nullptr || validity->test(index),
+          quote_character_, columns_[i], value, error);
+      }
+
+    protected:
+      ConvertingReader(std::array<std::string, N> columns, Converter converter) :
+        columns_(std::move(columns)),
+        converter_(std::move(converter)),
+        rows_ptoken_(ProducerToken(rows_)),
+        rows_ctoken_(ConsumerToken(rows_)) {}
+
+    private:
+      // Runs on the reading thread, before the first row
+      void resolve_columns(const std::vector<std::string>& headers) {
+        quote_character_ = reader_.schema()->quote_character();
+        for (size_t i = 0; i < N; ++i) {
+          auto it = std::find(headers.begin(), headers.end(), columns_[i]);
+          if (it == headers.end())
+            throw std::runtime_error("error: Column " + columns_[i] + " not found");
+          indices_[i] = static_cast<size_t>(it - headers.begin());
+        }
+      }
+
+      std::array<std::string, N> columns_;
+      std::array<size_t, N> indices_{};
+      char quote_character_ = '"';
+      Converter converter_;
+
+      // Declared before reader_ so that the reading thread is joined
+      // before the queue it writes to goes away
+      ConcurrentQueue<RowType> rows_;
+      ProducerToken rows_ptoken_;
+      ConsumerToken rows_ctoken_;
+      Reader reader_;
+    };
+
+    // Fills the elements of a tuple in order
+    template <typename... Ts>
+    struct TupleConverter {
+      template <typename Reader>
+      bool operator()(const Reader& reader, const std::vector<std::string_view>& fields,
+        const Bitmap* validity, std::tuple<Ts...>& row, std::string& error) const {
+        return convert(reader, fields, validity, row, error, std::index_sequence_for<Ts...>{});
+      }
+
+      template <typename Reader, size_t... Is>
+      bool convert(const Reader& reader, const std::vector<std::string_view>& fields,
+        const Bitmap* validity, std::tuple<Ts...>& row, std::string& error, std::index_sequence<Is...>) const {
+        return (reader.convert_field(fields, validity, Is, std::get<Is>(row), error) && ...);
+      }
+    };
+
+    // Fills the members of a struct, one per column
+    template <typename T, typename... Ms>
+    struct StructConverter {
+      std::tuple<Ms T::*...> members;
+
+      template <typename Reader>
+      bool operator()(const Reader& reader, const std::vector<std::string_view>& fields,
+        const Bitmap* validity, T& row, std::string& error) const {
+        return convert(reader, fields, validity, row, error, std::index_sequence_for<Ms...>{});
+      }
+
+      template <typename Reader, size_t... Is>
+      bool convert(const Reader& reader, const std::vector<std::string_view>& fields,
+        const Bitmap* validity, T& row, std::string& error, std::index_sequence<Is...>) const {
+        return (reader.convert_field(fields, validity, Is, row.*std::get<Is>(members), error) && ...);
+      }
+    };
+
+  }
+
+  // Reads rows straight into std::tuple<Ts...>. The columns are named 
+  // when the reader is created, matched against the header once, and the
+  // fields are converted on the reading thread. There are no maps and no
+  // per-field strings, except for std::string columns:
+  //
+  //   csv::TypedReader<int64_t, double, std::optional<bool>> reader({ "ts", "px", "active" });
+  //   reader.read("quotes.csv");
+  //   std::tuple<int64_t, double, std::optional<bool>> row;
+  //   while (reader.next(row)) { ... }
+  //
+  // Supported types are integers, float, double, bool, std::string, 
+  // csv::Timestamp, and std::optional of these for columns with nulls.
+  // A row that doesn't convert is a malformed row, see Dialect::error_policy()
+  template <typename... Ts>
+  class TypedReader : public detail::ConvertingReader<std::tuple<Ts...>, 
+    detail::TupleConverter<Ts...>, sizeof...(Ts)> {
+  public:
+    using row_type = std::tuple<Ts...>;
+
+    explicit TypedReader(std::array<std::string, sizeof...(Ts)> columns) :
+      TypedReader::ConvertingReader(std::move(columns), detail::TupleConverter<Ts...>{}) {}
+  };
+
+  // A column of a CSV file bound to a member of T, see StructReader
+  template <typename T, typename M>
+  struct Field {
+    std::string name;
+    M T::* member;
+  };
+
+  template <typename T, typename M>
+  Field<T, M> field(std::string name, M T::* member) {
+    return Field<T, M>{ std::move(name), member };
+  }
+
+  // Reads rows straight into a struct. Each member is bound to a column
+  // with csv::field(), and the reader fills the members on the reading
+  // thread, the same way as TypedReader:
+  //
+  //   struct Quote { int64_t ts; double px; std::optional<std::string> venue; };
+  //   csv::StructReader reader(csv::field("ts", &Quote::ts), csv::field("px", &Quote::px),
+  //     csv::field("venue", &Quote::venue));
+  //   reader.read("quotes.csv");
+  //   std::vector<Quote> quotes = reader.rows();
+  //
+  // Members that aren't bound keep the value they get from T{}
+  template <typename T, typename... Ms>
+  class StructReader : public detail::ConvertingReader<T, 
+    detail::StructConverter<T, Ms...>, sizeof...(Ms)> {
+  public:
+    using row_type = T;
+
+    explicit StructReader(Field<T, Ms>... fields) :
+      StructReader::ConvertingReader({ fields.name... },
+        detail::StructConverter<T, Ms...>{ std::make_tuple(fields.member...) }) {}
+  };
+
+}
@@ -0,0 +1,592 @@
+/*
+ _______  _______  __   __
+|      _||       ||  | |  |  Fast CSV Parser for Modern C++
+|     |  |  _____||  |_|  |  http://github.com/p-ranav/csv
+|     |  | |_____ |       |
+|     |  |_____  ||       |
+|     |_  _____| | |     |
+|_______||_______|  |___|
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2019 Pranav Srinivas Kumar <pranav.srinivas.kumar@gmail.com>.
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+namespace csv {
+
+  // Column types that can be declared in a Dialect with .column_type(...)
+  enum class Type {
+    string,
+    int64,
+    float64,
+    boolean,
+    decimal,
+    timestamp,
+    dictionary
+  };
+
+  // A declared column type. scale is the number of digits kept after
+  // the decimal point and only applies to Type::decimal
+  struct ColumnType {
+    Type type;
+    int scale;
+  };
+
+  // An exact fixed-point number, equal to value / 10^scale
+  struct Decimal {
+    int64_t value;
+    int scale;
+
+    bool operator==(const Decimal& other) const {
+      return value == other.value && scale == other.scale;
+    }
+
+    bool operator!=(const Decimal& other) const {
+      return !(*this == other);
+    }
+
+    std::string to_string() const {
+      uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+      std::string digits = std::to_string(magnitude);
+      if (scale <= 0)
+        return (value < 0 ? "-" : "") + digits;
+      if (digits.size() <= static_cast<size_t>(scale))
+        digits.insert(0, static_cast<size_t>(scale) + 1 - digits.size(), '0');
+      digits.insert(digits.size() - static_cast<size_t>(scale), 1, '.');
+      return (value < 0 ? "-" : "") + digits;
+    }
+  };
+
+  // A point in time, in nanoseconds since the Unix epoch (UTC)
+  struct Timestamp {
+    int64_t nanoseconds;
+
+    bool operator==(const Timestamp& other) const {
+      return nanoseconds == other.nanoseconds;
+    }
+
+    bool operator!=(const Timestamp& other) const {
+      return !(*this == other);
+    }
+  };
+
+  // A parsed value. Columns without a declared type, and values that 
+  // fail to convert to the declared type, hold the original text
+  using Value = std::variant<std::string, int64_t, double, bool, Decimal, Timestamp>;
+
+  // One validity bit per field, 1 = valid and 0 = null. Bits are numbered
+  // from the least significant bit of the first byte, like Arrow's
+  // validity buffers, so they can be handed out as-is
+  class Bitmap {
+  public:
+    Bitmap() : size_(0) {}
+
+    explicit Bitmap(size_t size, bool value = true) {
+      resize(size, value);
+    }
+
+    void resize(size_t size, bool value = true) {
+      size_ = size;
+      bytes_.assign((size + 7) / 8, value ? 0xFF : 0x00);
+    }
+
+    // Mark every bit valid, or every bit null
+    void fill(bool value) {
+      if (!bytes_.empty())
+        std::memset(bytes_.data(), value ? 0xFF : 0x00, bytes_.size());
+    }
+
+    // Add a bit at the end
+    void push_back(bool value) {
+      if (size_ % 8 == 0)
+        bytes_.push_back(0);
+      size_ += 1;
+      set(size_ - 1, value);
+    }
+
+    void reserve(size_t size) {
+      bytes_.reserve((size + 7) / 8);
+    }
+
+    void clear() {
+      size_ = 0;
+      bytes_.clear();
+    }
+
+    void set(size_t index, bool value) {
+      if (value)
+        bytes_[index / 8] |= static_cast<uint8_t>(1u << (index % 8));
+      else
+        bytes_[index / 8] &= static_cast<uint8_t>(~(1u << (index % 8)));
+    }
+
+    bool test(size_t index) const {
+      return (bytes_[index / 8] >> (index % 8)) & 1;
+    }
+
+    // Number of null bits
+    size_t null_count() const {
+      size_t count = 0;
+      for (size_t i = 0; i < size_; ++i)
+        count += !test(i);
+      return count;
+    }
+
+    size_t size() const {
+      return size_;
+    }
+
+    const uint8_t* data() const {
+      return bytes_.data();
+    }
+
+  private:
+    size_t size_;
+    std::vector<uint8_t> bytes_;
+  };
+
+  // Check if 8 bytes, loaded in little-endian order, are all ASCII digits
+  inline bool is_eight_digits(uint64_t chunk) {
+    return (((chunk & 0xF0F0F0F0F0F0F0F0) |
+      (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333);
+  }
+
+  // Convert 8 ASCII digits, loaded in little-endian order, in a handful of 
+  // multiplications instead of 8 dependent multiply-adds
+  inline uint32_t parse_eight_digits(uint64_t chunk) {
+    const uint64_t mask = 0x000000FF000000FF;
+    const uint64_t mul1 = 0x000F424000000064; // 100 + (1000000ULL << 32)
+    const uint64_t mul2 = 0x0000271000000001; // 1 + (10000ULL << 32)
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+    return static_cast<uint32_t>(chunk);
+  }
+
+  // Parse a base-10 integer with an optional sign
+  // Returns false on malformed input or if the value doesn't fit in int64_t
+  inline bool parse_int64(std::string_view input, int64_t& result) {
+    const char* p = input.data();
+    const char* end = p + input.size();
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      negative = (*p == '-');
+      ++p;
+    }
+    if (p == end)
+      return false;
+    while (p != end && *p == '0')
+      ++p;
+
+    const char* digits_start = p;
+    uint64_t magnitude = 0;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // At most two 8-digit blocks, so that magnitude can't overflow here
+    while (end - p >= 8 && p - digits_start <= 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, p, sizeof(chunk));
+      if (!is_eight_digits(chunk))
+        break;
+      magnitude = magnitude * 100000000 + parse_eight_digits(chunk);
+      p += 8;
+    }
+#endif
+    while (p != end && *p >= '0' && *p <= '9' && p - digits_start < 20) {
+      magnitude = magnitude * 10 + static_cast<uint64_t>(*p - '0');
+      ++p;
+    }
+    if (p != end)
+      return false;
+
+    // 19 digits always fit in a uint64_t, so this is the only overflow check needed
+    size_t digits = static_cast<size_t>(p - digits_start);
+    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0);
+    if (digits > 19 || magnitude > limit)
+      return false;
+
+    result = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+  }
+
+  // Parse a floating-point number without depending on the current locale
+  inline bool parse_double(std::string_view input, double& result) {
+    if (input.empty())
+      return false;
+    // from_chars doesn't take a '+', and strtod would take a second sign
+    if (input[0] == '+') {
+      input.remove_prefix(1);
+      if (input.empty() || input[0] == '+' || input[0] == '-')
+        return false;
+    }
+#if defined(__cpp_lib_to_chars)
+    auto conversion = std::from_chars(input.data(), input.data() + input.size(), result);
+    return conversion.ec == std::errc() && conversion.ptr == input.data() + input.size();
+#else
+    // strtod needs a null-terminated buffer
+    char buffer[64];
+    if (input.size() >= sizeof(buffer))
+      return false;
+    std::memcpy(buffer, input.data(), input.size());
+    buffer[input.size()] = '\0';
+    char* parsed_end = nullptr;
+    result = std::strtod(buffer, &parsed_end);
+    return parsed_end == buffer + input.size();
+#endif
+  }
+
+  // Accepts true/false in any case, and 1/0
+  inline bool parse_bool(std::string_view input, bool& result) {
+    auto equals = [](std::string_view lhs, std::string_view rhs) {
+      if (lhs.size() != rhs.size())
+        return false;
+      for (size_t i = 0; i < lhs.size(); ++i)
+        if ((lhs[i] | 0x20) != rhs[i])
+          return false;
+      return true;
+    };
+    if (input == "1" || equals(input, "true")) {
+      result = true;
+      return true;
+    }
+    if (input == "0" || equals(input, "false")) {
+      result = false;
+      return true;
+    }
+    return false;
+  }
+
+  // Parse a decimal number into value * 10^scale without going through
+  // binary floating point, e.g., "123.4500" with scale 2 is 12345
+  // Returns false on malformed input, on non-zero digits beyond the scale 
+  // (they can't be represented exactly) or if the result doesn't fit in int64_t
+  inline bool parse_decimal(std::string_view input, int scale, int64_t& result) {
+    static const uint64_t powers_of_ten[] = {
+      1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+      100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+      10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+      100000000000000000ULL, 1000000000000000000ULL
+    };
+    if (scale < 0 || scale > 18)
+      return false;
+
+    bool negative = false;
+    if (!input.empty() && (input[0] == '-' || input[0] == '+')) {
+      negative = (input[0] == '-');
+      input.remove_prefix(1);
+    }
+
+    size_t point = input.find('.');
+    std::string_view integer_part = input.substr(0, point);
+    std::string_view fraction = (point == std::string_view::npos) ? std::string_view() : input.substr(point + 1);
+    if (integer_part.empty() && fraction.empty())
+      return false;
+
+    while (fraction.size() > static_cast<size_t>(scale)) {
+      if (fraction.back() != '0')
+        return false;
+      fraction.remove_suffix(1);
+    }
+
+    // Both parts are plain digit sequences; the sign has already been consumed
+    auto parse_digits = [](std::string_view digits, uint64_t& value) {
+      int64_t parsed = 0;
+      if (digits.empty()) {
+        value = 0;
+        return true;
+      }
+      if (digits[0] < '0' || digits[0] > '9' || !parse_int64(digits, parsed))
+        return false;
+      value = static_cast<uint64_t>(parsed);
+      return true;
+    };
+
+    uint64_t integer_value = 0, fraction_value = 0;
+    if (!parse_digits(integer_part, integer_value) || !parse_digits(fraction, fraction_value))
+      return false;
+    fraction_value *= powers_of_ten[static_cast<size_t>(scale) - fraction.size()];
+
+    const uint64_t multiplier = powers_of_ten[scale];
+    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0);
+    if (integer_value > (limit - fraction_value) / multiplier)
+      return false;
+
+    uint64_t magnitude = integer_value * multiplier + fraction_value;
+    result = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+  }
+
+  // Number of days between 1970-01-01 and the given date in the proleptic
+  // Gregorian calendar (Howard Hinnant's days_from_civil)
+  inline int64_t days_from_civil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+  }
+
+  // Parse an ISO-8601 timestamp into nanoseconds since the Unix epoch
+  // Accepted forms are YYYY-MM-DD, optionally followed by 'T' or ' ' and 
+  // HH:MM:SS, an optional fraction of up to 9 digits and an optional 
+  // offset: Z, +HH, +HHMM or +HH:MM (or their negative counterparts)
+  // The fixed-width fields are validated together so that well-formed
+  // input runs without data-dependent branches
+  inline bool parse_timestamp(std::string_view input, int64_t& result) {
+    const size_t size = input.size();
+    if (size < 10)
+      return false;
+    const char* p = input.data();
+
+    // Any byte outside '0'..'9' sets a bit in invalid
+    unsigned invalid = 0;
+    auto digit = [&](size_t i) {
+      unsigned value = static_cast<unsigned char>(p[i]) - static_cast<unsigned>('0');
+      invalid |= (value > 9);
+      return value;
+    };
+
+    const int64_t year = digit(0) * 1000 + digit(1) * 100 + digit(2) * 10 + digit(3);
+    const unsigned month = digit(5) * 10 + digit(6);
+    const unsigned day = digit(8) * 10 + digit(9);
+    invalid |= (p[4] != '-') | (p[7] != '-');
+
+    unsigned hour = 0, minute = 0, second = 0;
+    size_t i = 10;
+    if (size > 10 && (p[10] == 'T' || p[10] == ' ')) {
+      if (size < 19)
+        return false;
+      hour = digit(11) * 10 + digit(12);
+      minute = digit(14) * 10 + digit(15);
+      second = digit(17) * 10 + digit(18);
+      invalid |= (p[13] != ':') | (p[16] != ':');
+      i = 19;
+    }
+
+    static const unsigned days_in_month[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const bool leap_year = (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
+    if (invalid || month < 1 || month > 12 || day < 1 || day > days_in_month[month - 1] ||
+      (month == 2 && day == 29 && !leap_year) || hour > 23 || minute > 59 || second > 59)
+      return false;
+
+    int64_t nanoseconds = 0;
+    if (i < size && (p[i] == '.' || p[i] == ',')) {
+      size_t fraction_start = ++i;
+      while (i < size && p[i] >= '0' && p[i] <= '9') {
+        if (i - fraction_start < 9)
+          nanoseconds = nanoseconds * 10 + (p[i] - '0');
+        ++i;
+      }
+      size_t fraction_digits = i - fraction_start;
+      if (fraction_digits == 0)
+        return false;
+      for (size_t j = fraction_digits; j < 9; ++j)
+        nanoseconds *= 10;
+    }
+
+    int64_t offset_seconds = 0;
+    if (i < size) {
+      if (p[i] == 'Z' || p[i] == 'z') {
+        i += 1;
+      }
+      else if (p[i] == '+' || p[i] == '-') {
+        const int64_t sign = (p[i] == '-') ? -1 : 1;
+        size_t remaining = size - i - 1;
+        unsigned offset_hours = 0, offset_minutes = 0;
+        if (remaining == 2) {
+          offset_hours = digit(i + 1) * 10 + digit(i + 2);
+        }
+        else if (remaining == 4) {
+          offset_hours = digit(i + 1) * 10 + digit(i + 2);
+          offset_minutes = digit(i + 3) * 10 + digit(i + 4);
+        }
+        else if (remaining == 5 && p[i + 3] == ':') {
+          offset_hours = digit(i + 1) * 10 + digit(i + 2);
+          offset_minutes = digit(i + 4) * 10 + digit(i + 5);
+        }
+        else
+          return false;
+        if (invalid || offset_hours > 23 || offset_minutes > 59)
+          return false;
+        offset_seconds = sign * static_cast<int64_t>(offset_hours * 3600 + offset_minutes * 60);
+        i = size;
+      }
+    }
+    if (i != size)
+      return false;
+
+    const int64_t seconds = days_from_civil(year, month, day) * 86400 +
+      hour * 3600 + minute * 60 + second - offset_seconds;
+
+    // int64_t nanoseconds cover the years 1677 to 2262
+    const int64_t max_seconds = std::numeric_limits<int64_t>::max() / 1000000000;
+    if (seconds >= max_seconds || seconds <= -max_seconds)
+      return false;
+
+    result = seconds * 1000000000 + nanoseconds;
+    return true;
+  }
+
+  // Remove the quote characters around a value, if any
+  inline std::string_view strip_quotes(std::string_view input, char quote_character) {
+    if (input.size() >= 2 && input.front() == quote_character && input.back() == quote_character)
+      return input.substr(1, input.size() - 2);
+    return input;
+  }
+
+  // A field converted to its column's type, without the text, so it can
+  // be stored in an arena next to the row's fields. integer holds int64,
+  // decimal (unscaled) and timestamp values. type is Type::string if the
+  // field is a string or didn't convert
+  struct ConvertedField {
+    Type type;
+    union {
+      int64_t integer;
+      double real;
+      bool boolean;
+    };
+  };
+
+  // Convert input to the given column type
+  // Surrounding quote characters, if any, are ignored for non-string types
+  // Type::dictionary only changes how record batches store a column and 
+  // is a string here
+  inline ConvertedField convert_field(std::string_view input, ColumnType column_type, char quote_character = '"') {
+    ConvertedField result;
+    result.type = Type::string;
+    result.integer = 0;
+    const Type type = column_type.type;
+    if (type == Type::string || type == Type::dictionary)
+      return result;
+    std::string_view unquoted = strip_quotes(input, quote_character);
+
+    bool converted = false;
+    switch (type) {
+    case Type::int64:
+      converted = parse_int64(unquoted, result.integer);
+      break;
+    case Type::float64:
+      converted = parse_double(unquoted, result.real);
+      break;
+    case Type::boolean:
+      converted = parse_bool(unquoted, result.boolean);
+      break;
+    case Type::decimal:
+      converted = parse_decimal(unquoted, column_type.scale, result.integer);
+      break;
+    case Type::timestamp:
+      converted = parse_timestamp(unquoted, result.integer);
+      break;
+    default:
+      break;
+    }
+    if (converted)
+      result.type = type;
+    return result;
+  }
+
+  // The Value of a converted field. input is the field's text, for
+  // fields that didn't convert
+  inline Value to_value(const ConvertedField& field, ColumnType column_type, std::string_view input) {
+    switch (field.type) {
+    case Type::int64:
+      return Value(std::in_place_type<int64_t>, field.integer);
+    case Type::float64:
+      return Value(std::in_place_type<double>, field.real);
+    case Type::boolean:
+      return Value(std::in_place_type<bool>, field.boolean);
+    case Type::decimal:
+      return Value(std::in_place_type<Decimal>, Decimal{ field.integer, column_type.scale });
+    case Type::timestamp:
+      return Value(std::in_place_type<Timestamp>, Timestamp{ field.integer });
+    default:
+      return Value(std::in_place_type<std::string>, input);
+    }
+  }
+
+  // Convert input to the given column type, see convert_field()
+  inline Value parse_value(std::string_view input, ColumnType column_type, char quote_character = '"') {
+    return to_value(convert_field(input, column_type, quote_character), column_type, input);
+  }
+
+  // Convert a field straight to a C++ type, for readers that know their
+  // columns at compile time. Return false if the field doesn't convert.
+  // Surrounding quote characters are ignored except for strings
+  template <typename T>
+  inline typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, bool>::type
+    from_field(std::string_view input, char quote_character, T& result) {
+    int64_t value;
+    if (!parse_int64(strip_quotes(input, quote_character), value))
+      return false;
+    if (std::is_unsigned<T>::value ? value < 0 || static_cast<uint64_t>(value) > std::numeric_limits<T>::max() :
+      value < static_cast<int64_t>(std::numeric_limits<T>::min()) || value > static_cast<int64_t>(std::numeric_limits<T>::max()))
+      return false;
+    result = static_cast<T>(value);
+    return true;
+  }
+
+  inline bool from_field(std::string_view input, char quote_character, double& result) {
+    return parse_double(strip_quotes(input, quote_character), result);
+  }
+
+  inline bool from_field(std::string_view input, char quote_character, float& result) {
+    double value;
+    if (!parse_double(strip_quotes(input, quote_character), value))
+      return false;
+    result = static_cast<float>(value);
+    return true;
+  }
+
+  inline bool from_field(std::string_view input, char quote_character, bool& result) {
+    return parse_bool(strip_quotes(input, quote_character), result);
+  }
+
+  inline bool from_field(std::string_view input, char quote_character, Timestamp& result) {
+    return parse_timestamp(strip_quotes(input, quote_character), result.nanoseconds);
+  }
+
+  inline bool from_field(std::string_view input, char, std::string& result) {
+    result.assign(input.data(), input.size());
+    return true;
+  }
+
+  // std::optional<T> columns are empty for null fields, see Dialect::null_values()
+  template <typename T>
+  struct is_optional : std::false_type {};
+
+  template <typename T>
+  struct is_optional<std::optional<T>> : std::true_type {};
+
+}
@@ -3,6 +3,10 @@
 #include <iostream>
 #include <csv/reader.hpp>
 #include <csv/writer.hpp>
+#include <csv/sniffer.hpp>
+#include <csv/peek.hpp>
+#include <csv/arrow.hpp>
+#include <csv/typed_reader.hpp>
 
 TEST_CASE("Parse an empty CSV", "[simple csv]") {
   csv::Reader csv;
@@ -547,4 +551,1278 @@ TEST_CASE("Parse exceptions", "[simple csv]") {
   REQUIRE(rows[5]["File"] == "/home/szyk/!-EnergoKod/!-Libs/EnergoKodInstrumenty/Tests/Src/ExceptionsTest.cpp");
   REQUIRE(rows[5]["Line"] == "72");
   REQUIRE(rows[5]["Function"] == "virtual void ExceptionsTest::run()");
-}
\ No newline at end of file
+}
+TEST_CASE("Parse CSV and filter rows on the parsing side", "[simple csv]") {
+  csv::Reader csv;
+  csv.filter("status", [](std::string_view status) { return status == "ERROR"; });
+  csv.read("inputs/filter.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["id"] == "2");
+  REQUIRE(rows[0]["message"] == "disk full");
+  REQUIRE(rows[1]["id"] == "5");
+  REQUIRE(rows[1]["message"] == "\"timeout, retrying\"");
+  REQUIRE(csv.shape().first == 2);
+}
+
+TEST_CASE("Parse CSV and combine filters over raw field views", "[simple csv]") {
+  csv::Reader csv;
+  csv.filter([](const std::vector<std::string_view>& fields) { return fields[1] != "OK"; });
+  csv.filter([](const std::vector<std::string_view>& fields) { return fields[0] != "2"; });
+  csv.read("inputs/filter.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["id"] == "4");
+  REQUIRE(rows[0]["status"] == "WARN");
+  REQUIRE(rows[1]["id"] == "5");
+}
+
+TEST_CASE("Parse CSV with a filter that rejects every row", "[simple csv]") {
+  csv::Reader csv;
+  csv.filter("status", [](std::string_view status) { return status == "FATAL"; });
+  csv.read("inputs/filter.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 0);
+}
+
+TEST_CASE("Parse CSV with a filter on an unknown column", "[simple csv]") {
+  csv::Reader csv;
+  csv.filter("state", [](std::string_view state) { return state == "ERROR"; });
+  csv.read("inputs/filter.csv");
+  REQUIRE_THROWS_WITH(csv.rows(), "error: Column state not found");
+}
+
+TEST_CASE("Sniff a semicolon-delimited CSV and parse it", "[sniffer]") {
+  auto dialect = csv::sniff("inputs/sniff_semicolon.csv");
+  REQUIRE(dialect.delimiter_ == ";");
+  REQUIRE(dialect.quote_character_ == '"');
+  REQUIRE(dialect.line_terminator_ == "\n");
+  REQUIRE(dialect.header_ == true);
+
+  csv::Reader csv;
+  csv.configure_dialect("sniffed") = dialect;
+  csv.read("inputs/sniff_semicolon.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0]["name"] == "Alice");
+  REQUIRE(rows[0]["city"] == "\"Paris; France\"");
+  REQUIRE(rows[2]["age"] == "41");
+}
+
+TEST_CASE("Sniff a pipe-delimited CSV without a header", "[sniffer]") {
+  auto dialect = csv::sniff("inputs/sniff_no_header.csv");
+  REQUIRE(dialect.delimiter_ == "|");
+  REQUIRE(dialect.header_ == false);
+}
+
+TEST_CASE("Sniff a tab-delimited CSV with single quotes and CR line endings", "[sniffer]") {
+  auto dialect = csv::sniff("inputs/sniff_tab_cr.csv");
+  REQUIRE(dialect.delimiter_ == "\t");
+  REQUIRE(dialect.quote_character_ == '\'');
+  REQUIRE(dialect.line_terminator_ == "\r");
+  REQUIRE(dialect.header_ == true);
+}
+
+TEST_CASE("Sniff only a bounded prefix of a CSV", "[sniffer]") {
+  auto dialect = csv::sniff("inputs/test_15.csv", 40);
+  REQUIRE(dialect.delimiter_ == ",");
+  REQUIRE(dialect.skip_initial_space_ == true);
+  REQUIRE(dialect.header_ == true);
+}
+
+TEST_CASE("Parse CSV with typed columns", "[typed csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("typed")
+    .column_type("id", csv::Type::int64)
+    .column_type("price", csv::Type::float64)
+    .column_type("active", csv::Type::boolean)
+    .column_type("quantity", csv::Type::int64);
+  csv.read("inputs/typed.csv");
+  auto rows = csv.typed_rows();
+  REQUIRE(rows.size() == 4);
+
+  REQUIRE(std::get<int64_t>(rows[0]["id"]) == 1);
+  REQUIRE(std::get<double>(rows[0]["price"]) == 10.5);
+  REQUIRE(std::get<bool>(rows[0]["active"]) == true);
+  REQUIRE(std::get<std::string>(rows[0]["name"]) == "foo");
+  REQUIRE(std::get<int64_t>(rows[0]["quantity"]) == 12345678901234567);
+
+  REQUIRE(std::get<int64_t>(rows[1]["id"]) == -42);
+  REQUIRE(std::get<double>(rows[1]["price"]) == 3.25);
+  REQUIRE(std::get<bool>(rows[1]["active"]) == false);
+  REQUIRE(std::get<int64_t>(rows[1]["quantity"]) == std::numeric_limits<int64_t>::max());
+
+  REQUIRE(std::get<int64_t>(rows[2]["id"]) == 7);
+  REQUIRE(std::get<double>(rows[2]["price"]) == -1000.0);
+  REQUIRE(std::get<bool>(rows[2]["active"]) == true);
+  REQUIRE(std::get<int64_t>(rows[2]["quantity"]) == std::numeric_limits<int64_t>::min());
+
+  // Values that don't convert keep their original text
+  REQUIRE(std::get<std::string>(rows[3]["id"]) == "x");
+  REQUIRE(std::get<std::string>(rows[3]["price"]) == "1.5.2");
+  REQUIRE(std::get<std::string>(rows[3]["active"]) == "maybe");
+  REQUIRE(std::get<std::string>(rows[3]["quantity"]) == "9223372036854775808");
+}
+
+TEST_CASE("Parse integers with and without 8-digit blocks", "[typed csv]") {
+  int64_t result = 0;
+  REQUIRE(csv::parse_int64("12345678", result));
+  REQUIRE(result == 12345678);
+  REQUIRE(csv::parse_int64("+1234567890123456789", result));
+  REQUIRE(result == 1234567890123456789);
+  REQUIRE(csv::parse_int64("0000000000000000000000001", result));
+  REQUIRE(result == 1);
+  REQUIRE_FALSE(csv::parse_int64("1234567a", result));
+  REQUIRE_FALSE(csv::parse_int64("12345678901234567890", result));
+  REQUIRE_FALSE(csv::parse_int64("-", result));
+  REQUIRE_FALSE(csv::parse_int64("", result));
+}
+
+TEST_CASE("Parse doubles with and without a sign", "[typed csv]") {
+  double result = 0;
+  REQUIRE(csv::parse_double("+2.5", result));
+  REQUIRE(result == 2.5);
+  REQUIRE(csv::parse_double("-1e3", result));
+  REQUIRE(result == -1000.0);
+  REQUIRE_FALSE(csv::parse_double("+-5", result));
+  REQUIRE_FALSE(csv::parse_double("++5", result));
+  REQUIRE_FALSE(csv::parse_double("+", result));
+  REQUIRE_FALSE(csv::parse_double("", result));
+  REQUIRE(std::get<std::string>(csv::parse_value("+-5", csv::ColumnType{ csv::Type::float64, 0 })) == "+-5");
+}
+
+TEST_CASE("Parse CSV with fixed-point decimal columns", "[typed csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("money")
+    .column_type("price", csv::Type::decimal, 4)
+    .column_type("fee", csv::Type::decimal, 2);
+  csv.read("inputs/decimal.csv");
+  auto rows = csv.typed_rows();
+  REQUIRE(rows.size() == 4);
+  REQUIRE(std::get<csv::Decimal>(rows[0]["price"]) == csv::Decimal{ 1234500, 4 });
+  REQUIRE(std::get<csv::Decimal>(rows[0]["price"]).to_string() == "123.4500");
+  REQUIRE(std::get<csv::Decimal>(rows[0]["fee"]) == csv::Decimal{ 1, 2 });
+  REQUIRE(std::get<csv::Decimal>(rows[1]["price"]) == csv::Decimal{ -5000, 4 });
+  REQUIRE(std::get<csv::Decimal>(rows[1]["price"]).to_string() == "-0.5000");
+  REQUIRE(std::get<csv::Decimal>(rows[1]["fee"]) == csv::Decimal{ 110, 2 });
+  REQUIRE(std::get<csv::Decimal>(rows[2]["price"]) == csv::Decimal{ 420000, 4 });
+
+  // 0.001 can't be represented exactly with 2 digits after the decimal point
+  REQUIRE(std::get<std::string>(rows[2]["fee"]) == "0.001");
+
+  // Doesn't fit in an int64_t once scaled
+  REQUIRE(std::get<std::string>(rows[3]["price"]) == "92233720368547.75807");
+  REQUIRE(std::get<std::string>(rows[3]["fee"]) == "1.2.3");
+}
+
+TEST_CASE("Parse decimals at the edges of the int64 range", "[typed csv]") {
+  int64_t result = 0;
+  REQUIRE(csv::parse_decimal("922337203685477.5807", 4, result));
+  REQUIRE(result == std::numeric_limits<int64_t>::max());
+  REQUIRE(csv::parse_decimal("-922337203685477.5808", 4, result));
+  REQUIRE(result == std::numeric_limits<int64_t>::min());
+  REQUIRE_FALSE(csv::parse_decimal("922337203685477.5808", 4, result));
+  REQUIRE(csv::parse_decimal(".25", 2, result));
+  REQUIRE(result == 25);
+  REQUIRE(csv::parse_decimal("7.", 1, result));
+  REQUIRE(result == 70);
+  REQUIRE_FALSE(csv::parse_decimal(".", 2, result));
+  REQUIRE_FALSE(csv::parse_decimal("1.-5", 2, result));
+}
+
+TEST_CASE("Parse CSV with ISO-8601 timestamp columns", "[typed csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("events")
+    .column_type("ts", csv::Type::timestamp);
+  csv.read("inputs/timestamps.csv");
+  auto rows = csv.typed_rows();
+  REQUIRE(rows.size() == 5);
+  REQUIRE(std::get<csv::Timestamp>(rows[0]["ts"]).nanoseconds == 1792224930123456000);
+  REQUIRE(std::get<csv::Timestamp>(rows[1]["ts"]) == std::get<csv::Timestamp>(rows[0]["ts"]));
+  REQUIRE(std::get<csv::Timestamp>(rows[2]["ts"]).nanoseconds == 86400000000000);
+  REQUIRE(std::get<csv::Timestamp>(rows[3]["ts"]).nanoseconds == -500000000);
+  REQUIRE(std::get<std::string>(rows[4]["ts"]) == "2026-02-30T00:00:00Z");
+}
+
+TEST_CASE("Parse ISO-8601 timestamps with offsets and fractions", "[typed csv]") {
+  int64_t result = 0;
+  REQUIRE(csv::parse_timestamp("2000-02-29T00:00:00-0130", result));
+  REQUIRE(result == (951782400LL + 5400) * 1000000000);
+  REQUIRE(csv::parse_timestamp("2000-02-29T00:00:00+01", result));
+  REQUIRE(result == (951782400LL - 3600) * 1000000000);
+  REQUIRE(csv::parse_timestamp("2000-02-29T00:00:00.123456789123Z", result));
+  REQUIRE(result == 951782400LL * 1000000000 + 123456789);
+  REQUIRE_FALSE(csv::parse_timestamp("1900-02-29", result));
+  REQUIRE_FALSE(csv::parse_timestamp("2000-13-01", result));
+  REQUIRE_FALSE(csv::parse_timestamp("2000-01-01T24:00:00", result));
+  REQUIRE_FALSE(csv::parse_timestamp("2000-01-01T00:00:00.", result));
+  REQUIRE_FALSE(csv::parse_timestamp("2000-01-01T00:00:00+1", result));
+  REQUIRE_FALSE(csv::parse_timestamp("3000-01-01", result));
+  REQUIRE_FALSE(csv::parse_timestamp("2000/01/01", result));
+}
+
+TEST_CASE("Parse CSV with backslash-escaped delimiters and quotes", "[simple csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("mysql")
+    .escape_character('\\');
+  csv.read("inputs/escaped.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0]["id"] == "1");
+  REQUIRE(rows[0]["name"] == "Smith, John");
+  REQUIRE(rows[0]["comment"] == "said \"hi\"");
+  REQUIRE(rows[1]["name"] == "C:\\temp");
+  REQUIRE(rows[1]["comment"] == "tab\there");
+  REQUIRE(rows[2]["name"] == "plain");
+  REQUIRE(rows[2]["comment"] == "\"quoted \", still quoted, here\"");
+}
+
+TEST_CASE("Scan for special characters across 16-byte blocks", "[scanner]") {
+  csv::Scanner scanner({ ',', '"' });
+  std::string input = "abcdefghijklmnopqrstuvwxyz,0123456789\"";
+  REQUIRE(scanner.find(input.data(), input.size(), 0) == 26);
+  REQUIRE(scanner.find(input.data(), input.size(), 27) == 37);
+  REQUIRE(scanner.find(input.data(), input.size(), 38) == 38);
+  REQUIRE(scanner.find(input.data(), 20, 0) == 20);
+}
+
+TEST_CASE("Parse CSV with a preamble and comment lines", "[simple csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("instrument")
+    .skip_lines(2)
+    .comment_character('#');
+  csv.read("inputs/comments.csv");
+  auto rows = csv.rows();
+  auto cols = csv.cols();
+  REQUIRE(cols.size() == 2);
+  REQUIRE(cols[0] == "channel");
+  REQUIRE(rows.size() == 4);
+  REQUIRE(rows[0]["channel"] == "1");
+  REQUIRE(rows[0]["value"] == "0.5");
+  REQUIRE(rows[1]["channel"] == "2");
+  REQUIRE(rows[2]["channel"] == "");
+  REQUIRE(rows[3]["channel"] == "3");
+  REQUIRE(rows[3]["value"] == "0.9");
+}
+
+TEST_CASE("Parse CSV without a header after a preamble", "[simple csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("instrument")
+    .skip_lines(5)
+    .comment_character('#')
+    .skip_empty_rows(true)
+    .header(false)
+    .column_names("channel", "value");
+  csv.read("inputs/comments.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0]["channel"] == "1");
+  REQUIRE(rows[1]["channel"] == "2");
+  REQUIRE(rows[2]["value"] == "0.9");
+}
+
+TEST_CASE("Parse CSV with unbalanced quotes in preamble and comment lines", "[simple csv]") {
+  csv::Reader csv;
+  csv.configure_dialect("quoted comments")
+    .skip_lines(1)
+    .comment_character('#');
+  csv.read("inputs/comment_quotes.csv");
+  auto rows = csv.rows();
+  auto cols = csv.cols();
+  REQUIRE(cols.size() == 2);
+  REQUIRE(cols[0] == "channel");
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["value"] == "0.5");
+  REQUIRE(rows[1]["channel"] == "2");
+  REQUIRE(rows[1]["value"] == "\"0.7\"");
+
+  csv::Dialect dialect;
+  dialect.skip_lines(1).comment_character('#');
+  std::ifstream stream("inputs/comment_quotes.csv", std::ios::binary);
+  REQUIRE(csv::count_rows(stream, dialect) == 2);
+}
+
+TEST_CASE("Parse CSV with CR line endings", "[line terminators]") {
+  csv::Reader csv;
+  csv.read("inputs/cr_line_endings.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["a"] == "1");
+  REQUIRE(rows[0]["c"] == "3");
+  REQUIRE(rows[1]["a"] == "4");
+  REQUIRE(rows[1]["c"] == "6");
+}
+
+TEST_CASE("Parse CSV with mixed line endings and a quoted line break", "[line terminators]") {
+  csv::Reader csv;
+  csv.read("inputs/mixed_line_endings.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0]["b"] == "\"two\r\nlines\"");
+  REQUIRE(rows[0]["c"] == "3");
+  REQUIRE(rows[1]["a"] == "4");
+  REQUIRE(rows[2]["a"] == "7");
+  REQUIRE(rows[2]["c"] == "9");
+}
+
+TEST_CASE("Parse CSV with a custom line terminator", "[line terminators]") {
+  csv::Reader csv;
+  csv.configure_dialect("tilde")
+    .delimiter("|")
+    .line_terminator("~~");
+  csv.read("inputs/custom_line_terminator.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["a"] == "1");
+  REQUIRE(rows[0]["b"] == "2");
+  REQUIRE(rows[1]["a"] == "3");
+  REQUIRE(rows[1]["b"] == "4");
+}
+
+TEST_CASE("Frame rows that straddle block boundaries", "[line terminators]") {
+  csv::Dialect dialect;
+  std::istringstream stream("ab,cd\r\n\"x\ny\",z\r\rlast row without terminator");
+  csv::RowFramer framer(stream, dialect, 3);
+  std::vector<std::string> rows;
+  std::string_view row;
+  while (framer.next(row))
+    rows.push_back(std::string(row));
+  REQUIRE(rows.size() == 4);
+  REQUIRE(rows[0] == "ab,cd");
+  REQUIRE(rows[1] == "\"x\ny\",z");
+  REQUIRE(rows[2] == "");
+  REQUIRE(rows[3] == "last row without terminator");
+}
+
+TEST_CASE("Parse UTF-8 CSV with a byte order mark", "[utf8]") {
+  csv::Reader csv;
+  csv.configure_dialect("utf8")
+    .validate_utf8(true);
+  csv.read("inputs/utf8_bom.csv");
+  auto rows = csv.rows();
+  auto cols = csv.cols();
+  REQUIRE(cols[0] == "id");
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["id"] == "1");
+  REQUIRE(rows[0]["name"] == "J\xc3\xbcrgen");
+  REQUIRE(rows[1]["name"] == "\xe6\x97\xa5\xe6\x9c\xac");
+}
+
+TEST_CASE("Parse CSV with invalid UTF-8", "[utf8]") {
+  csv::Reader csv;
+  csv.configure_dialect("utf8")
+    .validate_utf8(true);
+  csv.read("inputs/invalid_utf8.csv");
+  bool exception_thrown = false;
+  try {
+    csv.rows();
+  }
+  catch (csv::ParseError& error) {
+    exception_thrown = true;
+    REQUIRE(error.offset() == 18);
+  }
+  REQUIRE(exception_thrown);
+}
+
+TEST_CASE("Validate UTF-8 sequences", "[utf8]") {
+  auto validate = [](const std::string& input) { return csv::validate_utf8(input.data(), input.size()); };
+  REQUIRE(validate("plain ASCII that is longer than sixteen bytes") == 45);
+  REQUIRE(validate("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80") == 9);
+  REQUIRE(validate("abcdefghijklmnopq\xc0\xaf") == 17);        // overlong
+  REQUIRE(validate("\xed\xa0\x80") == 0);                      // surrogate
+  REQUIRE(validate("\xf4\x90\x80\x80") == 0);                  // beyond U+10FFFF
+  REQUIRE(validate("ok\xe2\x82") == 2);                        // truncated
+}
+
+TEST_CASE("Parse UTF-16LE CSV with a byte order mark", "[encodings]") {
+  csv::Reader csv;
+  csv.configure_dialect("utf16")
+    .encoding(csv::Encoding::utf16le);
+  csv.read("inputs/utf16le.csv");
+  auto rows = csv.rows();
+  REQUIRE(csv.cols()[0] == "name");
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["name"] == "J\xc3\xbcrgen");
+  REQUIRE(rows[0]["city"] == "K\xc3\xb6ln");
+  REQUIRE(rows[0]["price"] == "5\xe2\x82\xac");
+  REQUIRE(rows[1]["name"] == "\"Zo\xc3\xab\"");
+  REQUIRE(rows[1]["price"] == "\"1,5\"");
+}
+
+TEST_CASE("Row positions of UTF-16 CSV are offsets in the file", "[encodings]") {
+  csv::Reader csv;
+  csv.configure_dialect("utf16")
+    .encoding(csv::Encoding::utf16le);
+  csv.read("inputs/utf16le.csv");
+  std::vector<size_t> offsets, lines;
+  csv::RowPosition position;
+  while (!csv.done()) {
+    if (csv.ready()) {
+      csv.next_row(position);
+      offsets.push_back(position.offset);
+      lines.push_back(position.line);
+    }
+  }
+  REQUIRE(offsets == std::vector<size_t>{ 34, 64 });
+  REQUIRE(lines == std::vector<size_t>{ 2, 3 });
+
+  // Surrogate pairs take four bytes, across small blocks
+  std::string utf16;
+  for (char16_t unit : std::u16string(u"a,\U0001F600\n\u00e9,bcdefghijklmnop\nx\n"))
+    utf16 += std::string{ static_cast<char>(unit & 0xFF), static_cast<char>(unit >> 8) };
+  std::istringstream source(utf16);
+  csv::TranscodingBuffer transcoder(source, csv::Encoding::utf16le, 5);
+  std::istream transcoded(&transcoder);
+  csv::RowFramer framer(transcoded, csv::Dialect(), 4);
+  framer.map_offsets(transcoder);
+  std::string_view row;
+  offsets.clear();
+  while (framer.next(row))
+    offsets.push_back(framer.row_offset());
+  REQUIRE(offsets == std::vector<size_t>{ 0, 10, 46 });
+}
+
+TEST_CASE("Parse UTF-16BE CSV with surrogate pairs", "[encodings]") {
+  csv::Reader csv;
+  csv.configure_dialect("utf16")
+    .encoding(csv::Encoding::utf16be)
+    .validate_utf8(true);
+  csv.read("inputs/utf16be.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["price"] == "5\xf0\x9f\x98\x80");
+  REQUIRE(rows[1]["city"] == "Z\xc3\xbcrich");
+}
+
+TEST_CASE("Parse Windows-1252 CSV", "[encodings]") {
+  csv::Reader csv;
+  csv.configure_dialect("windows")
+    .encoding(csv::Encoding::windows1252);
+  csv.read("inputs/windows1252.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[0]["name"] == "\xe2\x80\x9cJ\xc3\xbcrgen\xe2\x80\x9d");
+  REQUIRE(rows[0]["price"] == "5\xe2\x82\xac");
+  REQUIRE(rows[1]["city"] == "Z\xc3\xbcrich");
+}
+
+TEST_CASE("Transcode UTF-16 split across small blocks", "[encodings]") {
+  std::string utf16;
+  for (char16_t unit : std::u16string(u"a,\U0001F600\né,bcdefghijklmnop\n"))
+    utf16 += std::string{ static_cast<char>(unit & 0xFF), static_cast<char>(unit >> 8) };
+  std::istringstream source(utf16);
+  csv::TranscodingBuffer transcoder(source, csv::Encoding::utf16le, 5);
+  std::istream transcoded(&transcoder);
+  std::string result((std::istreambuf_iterator<char>(transcoded)), std::istreambuf_iterator<char>());
+  REQUIRE(result == "a,\xf0\x9f\x98\x80\n\xc3\xa9,bcdefghijklmnop\n");
+}
+
+TEST_CASE("Parse CSV with null tokens", "[null values]") {
+  csv::Reader csv;
+  csv.configure_dialect("nulls")
+    .null_values("NA", "NULL", "\\N", "");
+  csv.read("inputs/nulls.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 4);
+  REQUIRE(rows[0].count("name") == 0);
+  REQUIRE(rows[0]["score"] == "3.5");
+  REQUIRE(rows[0].count("comment") == 0);
+  REQUIRE(rows[1]["name"] == "Bob");
+  REQUIRE(rows[1].count("score") == 0);
+  REQUIRE(rows[1]["comment"] == "fine");
+  // Quoted tokens are values
+  REQUIRE(rows[2]["name"] == "\"NA\"");
+  REQUIRE(rows[2]["score"] == " 7 ");
+  REQUIRE(rows[2].count("comment") == 0);
+  // Missing fields are empty, and so null
+  REQUIRE(rows[3]["name"] == "Dana");
+  REQUIRE(rows[3].count("score") == 0);
+  REQUIRE(rows[3].count("comment") == 0);
+}
+
+TEST_CASE("Parse typed CSV with null tokens", "[null values]") {
+  csv::Reader csv;
+  csv.configure_dialect("typed nulls")
+    .null_values("NA", "NULL")
+    .trim_characters(' ')
+    .column_type("id", csv::Type::int64)
+    .column_type("score", csv::Type::float64);
+  csv.read("inputs/nulls.csv");
+  auto rows = csv.typed_rows();
+  REQUIRE(rows.size() == 4);
+  REQUIRE(std::get<int64_t>(rows[0]["id"]) == 1);
+  REQUIRE(rows[0].count("name") == 0);
+  REQUIRE(std::get<double>(rows[0]["score"]) == 3.5);
+  REQUIRE(rows[1].count("score") == 0);
+  REQUIRE(std::get<double>(rows[2]["score"]) == 7.0);
+  REQUIRE(std::get<std::string>(rows[3]["comment"]) == "");
+}
+
+TEST_CASE("Validity bitmap", "[null values]") {
+  csv::Bitmap validity(10);
+  REQUIRE(validity.null_count() == 0);
+  validity.set(0, false);
+  validity.set(9, false);
+  REQUIRE(!validity.test(0));
+  REQUIRE(validity.test(1));
+  REQUIRE(!validity.test(9));
+  REQUIRE(validity.null_count() == 2);
+  REQUIRE(validity.data()[0] == 0xFE);
+  validity.fill(true);
+  REQUIRE(validity.null_count() == 0);
+}
+
+TEST_CASE("Pad malformed rows by default", "[error policy]") {
+  csv::Reader csv;
+  csv.read("inputs/malformed.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 5);
+  REQUIRE(rows[1]["a"] == "4");
+  REQUIRE(rows[1]["c"] == "");
+  REQUIRE(rows[2]["c"] == "\"8,x\"");
+  REQUIRE(csv.bad_rows() == 0);
+}
+
+TEST_CASE("Raise on the first malformed row", "[error policy]") {
+  csv::Reader csv;
+  csv.configure_dialect("strict")
+    .error_policy(csv::ErrorPolicy::strict);
+  csv.read("inputs/malformed.csv");
+  bool raised = false;
+  try {
+    csv.rows();
+  }
+  catch (const csv::ParseError& error) {
+    raised = true;
+    REQUIRE(error.offset() == 12);
+  }
+  REQUIRE(raised);
+}
+
+TEST_CASE("Hand out the rows before a malformed row, then raise", "[error policy]") {
+  csv::Reader csv;
+  csv.configure_dialect("strict")
+    .error_policy(csv::ErrorPolicy::strict);
+  csv.read("inputs/malformed_late.csv");
+  // Let the reading thread fail before any row is taken
+  while (!csv.finished()) {}
+  std::vector<std::string> ids;
+  bool raised = false;
+  try {
+    csv::Row row;
+    while (csv.next(row))
+      ids.push_back(std::string(row[0]));
+  }
+  catch (const csv::ParseError& error) {
+    raised = true;
+    REQUIRE(error.offset() == 24);
+  }
+  REQUIRE(raised);
+  REQUIRE(ids == std::vector<std::string>{ "1", "4", "7" });
+}
+
+TEST_CASE("Skip malformed rows", "[error policy]") {
+  csv::Reader csv;
+  csv.configure_dialect("skip")
+    .error_policy(csv::ErrorPolicy::skip);
+  csv.read("inputs/malformed.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0]["a"] == "1");
+  REQUIRE(rows[1]["a"] == "10");
+  REQUIRE(rows[2]["a"] == "13");
+  REQUIRE(rows[2]["c"] == "");
+  REQUIRE(csv.bad_rows() == 2);
+}
+
+TEST_CASE("Quarantine malformed rows", "[error policy]") {
+  std::remove("inputs/quarantined.csv");
+  csv::Reader csv;
+  csv.configure_dialect("quarantine")
+    .error_policy(csv::ErrorPolicy::quarantine)
+    .quarantine_file("inputs/quarantined.csv");
+  csv.read("inputs/malformed.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+
+  csv::RowError error;
+  REQUIRE(csv.next_error(error));
+  REQUIRE(error.offset == 12);
+  REQUIRE(error.reason == "Expected 3 fields but found 2");
+  REQUIRE(error.row == "4,5");
+  REQUIRE(csv.next_error(error));
+  REQUIRE(error.offset == 16);
+  REQUIRE(error.line == 4);
+  REQUIRE(error.row == "6,7,\"8,x\",9");
+  REQUIRE(!csv.next_error(error));
+
+  std::ifstream sink("inputs/quarantined.csv");
+  std::string contents((std::istreambuf_iterator<char>(sink)), std::istreambuf_iterator<char>());
+  REQUIRE(contents == "12,3,\"Expected 3 fields but found 2\",\"4,5\"\n"
+    "16,4,\"Expected 3 fields but found 4\",\"6,7,\"\"8,x\"\",9\"\n");
+  sink.close();
+  std::remove("inputs/quarantined.csv");
+}
+
+TEST_CASE("Report the byte offset and line number of every row", "[positions]") {
+  csv::Reader csv;
+  csv.read("inputs/positions.csv");
+  std::vector<csv::RowPosition> positions;
+  std::vector<std::string> ids;
+  while (!csv.done() || positions.size() < csv.shape().first) {
+    if (csv.ready()) {
+      csv::RowPosition position;
+      auto row = csv.next_row(position);
+      positions.push_back(position);
+      ids.push_back(row["id"]);
+    }
+  }
+  REQUIRE(positions.size() == 5);
+  REQUIRE(ids[0] == "1");
+  REQUIRE(positions[0].offset == 9);
+  REQUIRE(positions[0].line == 2);
+  REQUIRE(ids[1] == "2");
+  REQUIRE(positions[1].offset == 25);
+  REQUIRE(positions[1].line == 4);
+  REQUIRE(positions[2].offset == 34);
+  REQUIRE(positions[2].line == 5);
+  // The empty row
+  REQUIRE(positions[3].line == 8);
+  REQUIRE(ids[4] == "4");
+  REQUIRE(positions[4].offset == 47);
+  REQUIRE(positions[4].line == 9);
+}
+
+TEST_CASE("Count lines with a custom line terminator", "[positions]") {
+  std::istringstream stream("a,b~~1,\"x\ny\"~~2,z\n~~3,w");
+  csv::Dialect dialect;
+  dialect.line_terminator("~~");
+  csv::RowFramer framer(stream, dialect, 4);
+  std::string_view row;
+  std::vector<size_t> lines;
+  while (framer.next(row))
+    lines.push_back(framer.row_line());
+  REQUIRE(lines == std::vector<size_t>{ 1, 1, 2, 3 });
+}
+
+TEST_CASE("Count rows with line breaks inside quotes", "[count rows]") {
+  REQUIRE(csv::count_rows("inputs/test_01.csv") == 2);
+  REQUIRE(csv::count_rows("inputs/positions.csv") == 5);
+  csv::Dialect dialect;
+  dialect.skip_empty_rows(true);
+  REQUIRE(csv::count_rows("inputs/positions.csv", dialect) == 4);
+  dialect.comment_character('#');
+  std::ifstream stream("inputs/comments.csv", std::ios::binary);
+  REQUIRE(csv::count_rows("inputs/comments.csv", dialect) == csv::count_rows(stream, dialect));
+}
+
+TEST_CASE("Count rows in parallel chunks", "[count rows]") {
+  // Quoted line breaks end up on both sides of the chunk boundaries,
+  // and so do comment lines with unbalanced quotes
+  {
+    std::ofstream output("inputs/count_rows_large.csv", std::ios::binary);
+    output << "# Exported by \"Tool v2\n";
+    output << "id,text,value\n";
+    for (size_t i = 0; i < 150000; ++i) {
+      output << i << ",\"multi\nline " << i << ", \"\"quoted\"\"\r\ntext\"," << i * 3 << "\r\n";
+      if (i % 7 == 0)
+        output << "\n";
+      if (i % 11 == 0)
+        output << "# comment, with a \"quote\"\n";
+      if (i % 13 == 0)
+        output << "# 5\" screen, \"\"\"\n";
+    }
+  }
+  csv::Dialect dialect;
+  dialect.comment_character('#').skip_empty_rows(true);
+  std::ifstream stream("inputs/count_rows_large.csv", std::ios::binary);
+  size_t expected = csv::count_rows(stream, dialect);
+  REQUIRE(expected == 150000);
+  REQUIRE(csv::count_rows("inputs/count_rows_large.csv", dialect, 1) == expected);
+  REQUIRE(csv::count_rows("inputs/count_rows_large.csv", dialect, 3) == expected);
+  REQUIRE(csv::count_rows("inputs/count_rows_large.csv", dialect, 8) == expected);
+  stream.close();
+  std::remove("inputs/count_rows_large.csv");
+}
+
+TEST_CASE("Shape before reading has finished", "[count rows]") {
+  csv::Reader csv;
+  csv.read("inputs/test_01.csv");
+  REQUIRE(csv.shape().first == 2);
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 2);
+  REQUIRE(csv.shape() == std::make_pair(size_t(2), size_t(3)));
+}
+
+TEST_CASE("Peek at a small file", "[peek]") {
+  auto summary = csv::peek("inputs/sniff_semicolon.csv");
+  REQUIRE(summary.exact);
+  REQUIRE(summary.dialect.delimiter_ == ";");
+  csv::Reader csv;
+  csv.configure_dialect("peeked") = summary.dialect;
+  csv.read("inputs/sniff_semicolon.csv");
+  auto rows = csv.rows();
+  REQUIRE(summary.columns == csv.cols());
+  REQUIRE(summary.estimated_rows == rows.size());
+}
+
+TEST_CASE("Peek at a file larger than the sample", "[peek]") {
+  {
+    std::ofstream output("inputs/peek_large.csv", std::ios::binary);
+    output << "# exported\nid,name,\"value\"\n";
+    for (size_t i = 0; i < 20000; ++i)
+      output << 100000 + i << ",name " << (i % 97) << "," << (i * 7) % 1000 << ".5\n";
+  }
+  csv::Dialect dialect;
+  dialect.skip_lines(1);
+  auto summary = csv::peek("inputs/peek_large.csv", dialect, 4096);
+  REQUIRE(!summary.exact);
+  REQUIRE(summary.columns == std::vector<std::string>{ "id", "name", "\"value\"" });
+  REQUIRE(summary.estimated_rows > 18000);
+  REQUIRE(summary.estimated_rows < 22000);
+  std::remove("inputs/peek_large.csv");
+}
+
+TEST_CASE("Peek without a header", "[peek]") {
+  csv::Dialect dialect;
+  dialect.header(false);
+  auto summary = csv::peek("inputs/test_01.csv", dialect);
+  REQUIRE(summary.columns == std::vector<std::string>{ "0", "1", "2" });
+  REQUIRE(summary.estimated_rows == 3);
+}
+
+TEST_CASE("Read CSV as record batches", "[record batches]") {
+  csv::Reader csv;
+  csv.configure_dialect("batches")
+    .null_values("NA")
+    .column_type("id", csv::Type::int64)
+    .column_type("price", csv::Type::float64)
+    .column_type("active", csv::Type::boolean)
+    .column_type("when", csv::Type::timestamp);
+  csv.record_batches(2);
+  csv.read("inputs/batches.csv");
+
+  std::vector<csv::RecordBatch> batches;
+  csv::RecordBatch batch;
+  while (csv.next_record_batch(batch))
+    batches.push_back(std::move(batch));
+  REQUIRE(batches.size() == 3);
+  REQUIRE(batches[0].num_rows() == 2);
+  REQUIRE(batches[2].num_rows() == 1);
+  REQUIRE(batches[1].position().line == 4);
+
+  auto& first = batches[0];
+  REQUIRE(first.num_columns() == 5);
+  REQUIRE(first.column("id").integers() == std::vector<int64_t>{ 1, 2 });
+  REQUIRE(first.column("name").string(0) == "apple");
+  REQUIRE(first.column("name").is_null(1));
+  REQUIRE(first.column("name").null_count() == 1);
+  REQUIRE(first.column("price").float64(0) == 1.25);
+  // Values that don't convert are null
+  REQUIRE(first.column("price").is_null(1));
+  REQUIRE(first.column("active").boolean(0));
+  REQUIRE(!first.column("active").boolean(1));
+  REQUIRE(first.column("when").timestamp(1) == csv::Timestamp{ 1704153600000000000 });
+
+  auto& second = batches[1];
+  auto& names = second.column("name");
+  REQUIRE(names.string(0) == "\"cherry, red\"");
+  REQUIRE(names.string(1) == "");
+  REQUIRE(!names.is_null(1));
+  REQUIRE(names.offsets() == std::vector<int64_t>{ 0, 13, 13 });
+  REQUIRE(second.column("active").is_null(0));
+  REQUIRE(second.column("when").is_null(0));
+  REQUIRE(second.column("price").float64(1) == 4.0);
+}
+
+TEST_CASE("Record batches skip ignored columns", "[record batches]") {
+  csv::Reader csv;
+  csv.configure_dialect("ignore in batches")
+    .ignore_columns("name", "when");
+  csv.record_batches();
+  csv.read("inputs/batches.csv");
+  csv::RecordBatch batch;
+  REQUIRE(csv.next_record_batch(batch));
+  REQUIRE(batch.num_rows() == 5);
+  REQUIRE(batch.num_columns() == 3);
+  REQUIRE(batch.column(1).name() == "price");
+  REQUIRE(batch.column(1).string(2) == "3.5");
+  REQUIRE(!csv.next_record_batch(batch));
+}
+
+TEST_CASE("Read rows by index with a shared schema", "[rows]") {
+  csv::Reader csv;
+  csv.configure_dialect("rows")
+    .null_values("NA")
+    .column_type("price", csv::Type::float64);
+  csv.read("inputs/batches.csv");
+
+  std::vector<csv::Row> rows;
+  csv::Row row;
+  while (csv.next(row))
+    rows.push_back(row);
+  REQUIRE(rows.size() == 5);
+
+  auto schema = csv.schema();
+  REQUIRE(schema->size() == 5);
+  REQUIRE(schema->name(2) == "price");
+  REQUIRE(!schema->contains("color"));
+  REQUIRE_THROWS_AS(schema->handle("color"), std::runtime_error);
+  auto name = schema->handle("name");
+
+  REQUIRE(rows[0].size() == 5);
+  REQUIRE(rows[0][0] == "1");
+  REQUIRE(rows[0].get(name) == "apple");
+  REQUIRE(rows[2].get("name") == "\"cherry, red\"");
+  REQUIRE(rows[1].is_null(1));
+  REQUIRE(!rows[3].is_null(1));
+  REQUIRE(std::get<double>(rows[4].value(2)) == 5.75);
+  REQUIRE(std::get<std::string>(rows[4].value(1)) == "elder");
+  REQUIRE(rows[3].position().line == 5);
+  // All rows point at the same schema
+  REQUIRE(&rows[0].schema() == schema.get());
+  REQUIRE(&rows[4].schema() == schema.get());
+}
+
+TEST_CASE("Rows outlive the reader", "[rows]") {
+  csv::Row row;
+  {
+    csv::Reader csv;
+    csv.read("inputs/batches.csv");
+    REQUIRE(csv.next(row));
+  }
+  csv::Row copy = row;
+  REQUIRE(copy.get("name") == "apple");
+  REQUIRE(copy[4] == "2024-01-02T03:04:05Z");
+}
+
+TEST_CASE("Allocate from reference-counted arena chunks", "[arena]") {
+  csv::Arena arena(64);
+  char* first = static_cast<char*>(arena.allocate(24, 8));
+  char* second = static_cast<char*>(arena.allocate(24, 8));
+  REQUIRE(arena.chunks() == 1);
+  REQUIRE(second == first + 24);
+  // Held by the arena, its pool of chunks and this test
+  std::shared_ptr<csv::ArenaChunk> chunk = arena.chunk();
+  REQUIRE(chunk.use_count() == 3);
+
+  // Doesn't fit in what is left of the first chunk
+  arena.allocate(24, 8);
+  REQUIRE(arena.chunks() == 2);
+  REQUIRE(chunk.use_count() == 2);
+  REQUIRE(chunk->used() == 48);
+  const csv::ArenaChunk* second_chunk = arena.chunk().get();
+
+  // Larger than a chunk
+  arena.allocate(1000, 8);
+  REQUIRE(arena.chunks() == 3);
+  REQUIRE(arena.chunk()->capacity() >= 1000);
+
+  // The second chunk isn't referenced from outside anymore and is reused,
+  // while the first one is still in use
+  auto* values = arena.allocate_array<uint64_t>(2);
+  REQUIRE(reinterpret_cast<uintptr_t>(values) % alignof(uint64_t) == 0);
+  REQUIRE(arena.chunks() == 3);
+  REQUIRE(arena.chunk().get() == second_chunk);
+  REQUIRE(arena.chunk()->used() == 16);
+
+  chunk.reset();
+  arena.allocate(56, 8);
+  REQUIRE(arena.chunks() == 3);
+  REQUIRE(arena.chunk()->used() == 56);
+}
+
+TEST_CASE("Rows share arena chunks", "[arena]") {
+  csv::Reader csv;
+  csv.configure_dialect("rows in chunks")
+    .null_values("NA");
+  csv.read("inputs/batches.csv");
+  std::vector<csv::Row> rows;
+  csv::Row row;
+  while (csv.next(row))
+    rows.push_back(row);
+  REQUIRE(rows.size() == 5);
+  // Consecutive rows are laid out back to back
+  REQUIRE(rows[1][0].data() > rows[0][4].data());
+  REQUIRE(rows[1][0].data() - rows[0][4].data() < 256);
+  REQUIRE(rows[1].is_null(1));
+  REQUIRE(rows[2].get("name") == "\"cherry, red\"");
+  REQUIRE(rows[3][1].empty());
+}
+
+TEST_CASE("Dictionary-encoded columns in record batches", "[record batches]") {
+  csv::Reader csv;
+  csv.configure_dialect("dictionary")
+    .null_values("NA")
+    .column_type("name", csv::Type::dictionary)
+    .column_type("active", csv::Type::dictionary);
+  csv.record_batches(2);
+  csv.read("inputs/batches.csv");
+
+  std::vector<csv::RecordBatch> batches;
+  csv::RecordBatch batch;
+  while (csv.next_record_batch(batch))
+    batches.push_back(std::move(batch));
+  REQUIRE(batches.size() == 3);
+
+  auto& active = batches[0].column("active");
+  REQUIRE(active.codes() == std::vector<int32_t>{ 0, 1 });
+  REQUIRE(active.string(1) == "false");
+  REQUIRE(active.dictionary().size() == 2);
+
+  // Codes carry over from one batch to the next
+  auto& last = batches[2].column("active");
+  REQUIRE(last.code(0) == 1);
+  REQUIRE(last.dictionary().size() == 3);
+  REQUIRE(last.dictionary().value(2) == "TRUE");
+  REQUIRE(batches[1].column("active").is_null(0));
+  // Batches that add no values share the previous dictionary
+  REQUIRE(last.shared_dictionary() == batches[1].column("active").shared_dictionary());
+
+  auto& names = batches[1].column("name");
+  REQUIRE(batches[0].column("name").is_null(1));
+  REQUIRE(names.string(0) == "\"cherry, red\"");
+  REQUIRE(names.string(1) == "");
+  REQUIRE(names.dictionary().offsets() == std::vector<int64_t>{ 0, 5, 18, 18 });
+}
+
+TEST_CASE("Export record batches through the Arrow C data interface", "[arrow]") {
+  csv::Reader csv;
+  csv.configure_dialect("arrow")
+    .null_values("NA")
+    .column_type("id", csv::Type::int64)
+    .column_type("name", csv::Type::dictionary)
+    .column_type("price", csv::Type::decimal, 2)
+    .column_type("active", csv::Type::boolean)
+    .column_type("when", csv::Type::timestamp);
+  csv.record_batches();
+  csv.read("inputs/batches.csv");
+  csv::RecordBatch batch;
+  REQUIRE(csv.next_record_batch(batch));
+  const int64_t* ids = batch.column("id").integers().data();
+
+  ArrowSchema schema;
+  ArrowArray array;
+  csv::export_record_batch(std::move(batch), &array, &schema);
+
+  REQUIRE(std::string(schema.format) == "+s");
+  REQUIRE(schema.n_children == 5);
+  REQUIRE(std::string(schema.children[0]->name) == "id");
+  REQUIRE(std::string(schema.children[0]->format) == "l");
+  REQUIRE(std::string(schema.children[1]->format) == "i");
+  REQUIRE(std::string(schema.children[1]->dictionary->format) == "U");
+  REQUIRE(std::string(schema.children[2]->format) == "d:19,2");
+  REQUIRE(std::string(schema.children[3]->format) == "b");
+  REQUIRE(std::string(schema.children[4]->format) == "tsn:UTC");
+  REQUIRE(schema.children[4]->flags == ARROW_FLAG_NULLABLE);
+
+  REQUIRE(array.length == 5);
+  REQUIRE(array.n_children == 5);
+  // Buffers are shared with the batch, not copied
+  ArrowArray* id = array.children[0];
+  REQUIRE(id->buffers[1] == ids);
+  REQUIRE(id->buffers[0] == nullptr);
+  REQUIRE(id->null_count == 0);
+
+  ArrowArray* name = array.children[1];
+  REQUIRE(name->null_count == 1);
+  auto codes = static_cast<const int32_t*>(name->buffers[1]);
+  auto offsets = static_cast<const int64_t*>(name->dictionary->buffers[1]);
+  auto bytes = static_cast<const char*>(name->dictionary->buffers[2]);
+  REQUIRE(name->dictionary->length == 4);
+  REQUIRE(std::string(bytes + offsets[codes[4]], offsets[codes[4] + 1] - offsets[codes[4]]) == "elder");
+
+  ArrowArray* price = array.children[2];
+  auto decimals = static_cast<const int64_t*>(price->buffers[1]);
+  REQUIRE(decimals[0] == 125);
+  REQUIRE(decimals[1] == 0);
+  REQUIRE(price->null_count == 1);
+  auto validity = static_cast<const uint8_t*>(price->buffers[0]);
+  REQUIRE((validity[0] & 0x1F) == 0x1D);
+
+  array.release(&array);
+  REQUIRE(array.release == nullptr);
+  schema.release(&schema);
+  REQUIRE(schema.release == nullptr);
+}
+
+TEST_CASE("Read rows into tuples", "[typed reader]") {
+  csv::TypedReader<std::string, int64_t, std::optional<double>, bool> csv({ "name", "id", "price", "active" });
+  csv.configure_dialect("tuples")
+    .error_policy(csv::ErrorPolicy::skip);
+  csv.read("inputs/typed.csv");
+  auto rows = csv.rows();
+  // The last row has values that don't convert
+  REQUIRE(rows.size() == 3);
+  REQUIRE(csv.bad_rows() == 1);
+  REQUIRE(csv.indices() == std::array<size_t, 4>{ 3, 0, 1, 2 });
+  REQUIRE(std::get<0>(rows[0]) == "foo");
+  REQUIRE(std::get<1>(rows[1]) == -42);
+  REQUIRE(*std::get<2>(rows[1]) == 3.25);
+  REQUIRE(!std::get<3>(rows[1]));
+  REQUIRE(std::get<1>(rows[2]) == 7);
+}
+
+TEST_CASE("Typed readers handle nulls and missing columns", "[typed reader]") {
+  {
+    csv::TypedReader<int64_t, std::optional<std::string>, std::optional<bool>> csv({ "id", "name", "active" });
+    csv.configure_dialect("tuples with nulls")
+      .null_values("NA");
+    csv.read("inputs/batches.csv");
+    std::tuple<int64_t, std::optional<std::string>, std::optional<bool>> row;
+    std::vector<decltype(row)> rows;
+    while (csv.next(row))
+      rows.push_back(row);
+    REQUIRE(rows.size() == 5);
+    REQUIRE(!std::get<1>(rows[1]));
+    REQUIRE(*std::get<1>(rows[3]) == "");
+    REQUIRE(!std::get<2>(rows[2]));
+    REQUIRE(*std::get<2>(rows[3]));
+  }
+  {
+    csv::TypedReader<int64_t, double> csv({ "id", "volume" });
+    csv.read("inputs/batches.csv");
+    REQUIRE_THROWS_WITH(csv.rows(), "error: Column volume not found");
+  }
+  {
+    // Nulls in a column that isn't std::optional make the row malformed
+    csv::TypedReader<int64_t, std::string> csv({ "id", "name" });
+    csv.configure_dialect("strict tuples")
+      .null_values("NA")
+      .error_policy(csv::ErrorPolicy::strict);
+    csv.read("inputs/batches.csv");
+    REQUIRE_THROWS_AS(csv.rows(), csv::ParseError);
+  }
+}
+
+TEST_CASE("Quote reasons in the quarantine file", "[error policy]") {
+  std::remove("inputs/quarantined_reasons.csv");
+  {
+    // The reason names a column with a delimiter and quotes in it
+    csv::TypedReader<int64_t, double> csv({ "id", "\"price, EUR\"" });
+    csv.configure_dialect("quarantine")
+      .error_policy(csv::ErrorPolicy::quarantine)
+      .quarantine_file("inputs/quarantined_reasons.csv");
+    csv.read("inputs/quarantine_reasons.csv");
+    REQUIRE(csv.rows().size() == 1);
+  }
+
+  std::ifstream sink("inputs/quarantined_reasons.csv");
+  std::string contents((std::istreambuf_iterator<char>(sink)), std::istreambuf_iterator<char>());
+  sink.close();
+  REQUIRE(contents == "22,3,\"Invalid value in column \"\"price, EUR\"\"\",\"2,x\"\n");
+  std::remove("inputs/quarantined_reasons.csv");
+}
+
+TEST_CASE("Convert fields to C++ types", "[typed reader]") {
+  int8_t small = 0;
+  REQUIRE(csv::from_field("127", '"', small));
+  REQUIRE(small == 127);
+  REQUIRE(!csv::from_field("128", '"', small));
+  uint32_t count = 0;
+  REQUIRE(!csv::from_field("-1", '"', count));
+  REQUIRE(csv::from_field("\"42\"", '"', count));
+  REQUIRE(count == 42);
+  csv::Timestamp timestamp{ 0 };
+  REQUIRE(csv::from_field("1970-01-01T00:00:01Z", '"', timestamp));
+  REQUIRE(timestamp.nanoseconds == 1000000000);
+  std::string text;
+  REQUIRE(csv::from_field("\"a\"", '"', text));
+  REQUIRE(text == "\"a\"");
+}
+
+struct Fruit {
+  int64_t id;
+  std::optional<std::string> name;
+  double price;
+  std::optional<csv::Timestamp> when;
+  int unbound = -1;
+};
+
+TEST_CASE("Read rows into structs", "[struct reader]") {
+  csv::StructReader csv(
+    csv::field("when", &Fruit::when),
+    csv::field("id", &Fruit::id),
+    csv::field("name", &Fruit::name),
+    csv::field("price", &Fruit::price));
+  csv.configure_dialect("structs")
+    .null_values("NA")
+    .error_policy(csv::ErrorPolicy::quarantine);
+  csv.read("inputs/batches.csv");
+  std::vector<Fruit> fruits = csv.rows();
+
+  // "x" isn't a price and "bad" isn't a timestamp
+  REQUIRE(fruits.size() == 3);
+  REQUIRE(csv.bad_rows() == 2);
+  csv::RowError error;
+  REQUIRE(csv.next_error(error));
+  REQUIRE(error.line == 3);
+  REQUIRE(error.reason == "Invalid value in column price");
+  REQUIRE(csv.indices() == std::array<size_t, 4>{ 4, 0, 1, 2 });
+
+  REQUIRE(fruits[0].id == 1);
+  REQUIRE(*fruits[0].name == "apple");
+  REQUIRE(fruits[0].price == 1.25);
+  REQUIRE(fruits[0].when->nanoseconds == 1704164645000000000);
+  REQUIRE(fruits[0].unbound == -1);
+  REQUIRE(fruits[1].id == 4);
+  REQUIRE(*fruits[1].name == "");
+  REQUIRE(fruits[1].when->nanoseconds == 1709164800500000000);
+  REQUIRE(fruits[2].price == 5.75);
+  REQUIRE(csv.next_error(error));
+  REQUIRE(error.reason == "Invalid value in column when");
+}
+
+TEST_CASE("Recycle record batches", "[record batches]") {
+  csv::Reader csv;
+  csv.configure_dialect("recycled batches")
+    .column_type("id", csv::Type::int64)
+    .column_type("active", csv::Type::dictionary);
+  csv.record_batches(1);
+  csv.read("inputs/batches.csv");
+
+  std::vector<int64_t> ids;
+  std::vector<std::string> names;
+  std::vector<int32_t> codes;
+  csv::RecordBatch batch;
+  while (csv.next_record_batch(batch)) {
+    REQUIRE(batch.num_rows() == 1);
+    ids.push_back(batch.column("id").int64(0));
+    names.push_back(std::string(batch.column("name").string(0)));
+    codes.push_back(batch.column("active").code(0));
+    csv.recycle(std::move(batch));
+  }
+  REQUIRE(ids == std::vector<int64_t>{ 1, 2, 3, 4, 5 });
+  REQUIRE(names[2] == "\"cherry, red\"");
+  REQUIRE(codes == std::vector<int32_t>{ 0, 1, 2, 3, 1 });
+}
+
+TEST_CASE("Clear record batches", "[record batches]") {
+  csv::RecordBatch batch;
+  batch.add_column("name", csv::ColumnType{ csv::Type::string, 0 }, 4);
+  batch.add_column("id", csv::ColumnType{ csv::Type::int64, 0 }, 4);
+  std::vector<std::string_view> fields{ "apple", "1" };
+  std::vector<size_t> indices{ 0, 1 };
+  batch.append(fields, indices, nullptr, '"', csv::RowPosition{ 10, 2 });
+  batch.finish();
+  batch.clear();
+  REQUIRE(batch.num_rows() == 0);
+  REQUIRE(batch.num_columns() == 2);
+  REQUIRE(batch.column("name").offsets() == std::vector<int64_t>{ 0 });
+  REQUIRE(batch.column("id").integers().empty());
+  REQUIRE(batch.column("id").integers().capacity() >= 4);
+
+  fields = { "pear", "x" };
+  batch.append(fields, indices, nullptr, '"', csv::RowPosition{ 20, 3 });
+  REQUIRE(batch.position().line == 3);
+  REQUIRE(batch.column("name").string(0) == "pear");
+  REQUIRE(batch.column("id").is_null(0));
+  REQUIRE(batch.column("id").null_count() == 1);
+}
+
+TEST_CASE("Take rows in batches", "[rows]") {
+  csv::Reader csv;
+  csv.read("inputs/batches.csv");
+  std::vector<csv::Row> rows;
+  std::vector<std::string> ids;
+  size_t calls = 0;
+  while (csv.next_batch(rows, 2)) {
+    REQUIRE(rows.size() >= 1);
+    REQUIRE(rows.size() <= 2);
+    for (auto& row : rows)
+      ids.push_back(std::string(row[0]));
+    calls += 1;
+  }
+  REQUIRE(ids == std::vector<std::string>{ "1", "2", "3", "4", "5" });
+  REQUIRE(calls >= 3);
+  REQUIRE(rows.empty());
+  REQUIRE(csv.done());
+  REQUIRE_THROWS(csv.next_batch(rows, 0));
+}
+
+TEST_CASE("Mix ready() and next_batch()", "[rows]") {
+  csv::Reader csv;
+  csv.read("inputs/batches.csv");
+  // ready() holds on to the row it found, which next_batch() hands out first
+  while (!csv.ready()) {}
+  std::vector<csv::Row> rows;
+  std::vector<std::string> ids;
+  while (csv.next_batch(rows, 1000))
+    for (auto& row : rows)
+      ids.push_back(std::string(row.get("id")));
+  REQUIRE(ids == std::vector<std::string>{ "1", "2", "3", "4", "5" });
+}
+
+TEST_CASE("Split lazy rows on first access", "[lazy rows]") {
+  csv::Reader csv;
+  csv.configure_dialect("lazy")
+    .null_values("NA", "NULL", "\\N", "");
+  csv.lazy_rows();
+  csv.read("inputs/nulls.csv");
+  std::vector<csv::Row> rows;
+  csv::Row row;
+  while (csv.next(row))
+    rows.push_back(std::move(row));
+  REQUIRE(rows.size() == 4);
+
+  auto& first = rows[0];
+  REQUIRE(first.lazy());
+  REQUIRE(first.raw() == "1,NA,3.5,\\N");
+  REQUIRE(first.fields_split() == 0);
+  REQUIRE(first[0] == "1");
+  REQUIRE(first.fields_split() == 1);
+  REQUIRE(first.is_null(1));
+  REQUIRE(first.fields_split() == 2);
+  REQUIRE(first.is_null(3));
+  REQUIRE(first.fields_split() == 4);
+
+  // Copies split on their own
+  csv::Row copy = rows[1];
+  REQUIRE(copy.fields_split() == 0);
+  REQUIRE(copy.get("comment") == "fine");
+  REQUIRE(copy.is_null(2));
+  REQUIRE(rows[1].fields_split() == 0);
+
+  // Fields missing from a short row are empty, and null here
+  REQUIRE(rows[3][3] == "");
+  REQUIRE(rows[3].is_null(2));
+  REQUIRE(rows[3].get("name") == "Dana");
+  REQUIRE(rows[3].raw() == "4,Dana");
+  REQUIRE(!rows[2].is_null(1));
+  REQUIRE(rows[2].is_null(3));
+  REQUIRE(rows[2].position().line == 4);
+}
+
+TEST_CASE("Lazy rows match eager rows", "[lazy rows]") {
+  auto read = [](bool lazy) {
+    csv::Reader csv;
+    csv.configure_dialect("lazy escapes")
+      .escape_character('\\');
+    csv.lazy_rows(lazy);
+    csv.read("inputs/escaped.csv");
+    std::vector<std::vector<std::string>> result;
+    csv::Row row;
+    while (csv.next(row)) {
+      result.emplace_back();
+      // Last column first, so lazy rows are split in one go
+      for (size_t i = row.size(); i-- > 0;)
+        result.back().insert(result.back().begin(), std::string(row[i]));
+    }
+    return result;
+  };
+  auto eager = read(false);
+  REQUIRE(eager.size() == 3);
+  REQUIRE(eager[0][1] == "Smith, John");
+  REQUIRE(read(true) == eager);
+
+  // The map interface works on lazy rows too
+  csv::Reader csv;
+  csv.configure_dialect("lazy maps")
+    .escape_character('\\');
+  csv.lazy_rows();
+  csv.read("inputs/escaped.csv");
+  auto rows = csv.rows();
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0]["comment"] == "said \"hi\"");
+  REQUIRE(rows[1]["comment"] == "tab\there");
+}